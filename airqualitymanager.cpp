@@ -4,6 +4,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QUrlQuery>
+#include <limits>
 
 AirQualityManager::AirQualityManager(QObject *parent) : QObject(parent) {
     networkManager = new QNetworkAccessManager(this);
@@ -37,7 +38,7 @@ void AirQualityManager::fetchStations() {
 void AirQualityManager::fetchSensors(int stationId) {
     QUrl url(QString("https://api.gios.gov.pl/pjp-api/rest/station/sensors/%1").arg(stationId));
     QNetworkReply *reply = networkManager->get(QNetworkRequest(url));
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, stationId]() {
         if (reply->error() == QNetworkReply::NoError) {
             QList<Sensor> sensors;
             QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
@@ -49,7 +50,7 @@ void AirQualityManager::fetchSensors(int stationId) {
                 s.paramName = obj["param"].toObject()["paramName"].toString();
                 sensors.append(s);
             }
-            emit sensorsFetched(sensors);
+            emit sensorsFetched(stationId, sensors);
         } else {
             emit errorOccurred(reply->errorString());
         }
@@ -60,21 +61,9 @@ void AirQualityManager::fetchSensors(int stationId) {
 void AirQualityManager::fetchSensorData(int sensorId) {
     QUrl url(QString("https://api.gios.gov.pl/pjp-api/rest/data/getData/%1").arg(sensorId));
     QNetworkReply *reply = networkManager->get(QNetworkRequest(url));
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, sensorId]() {
         if (reply->error() == QNetworkReply::NoError) {
-            QList<Measurement> measurements;
-            QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-            QJsonObject obj = doc.object();
-            QJsonArray values = obj["values"].toArray();
-            for (const QJsonValue &value : values) {
-                QJsonObject measurementObj = value.toObject();
-                Measurement m;
-                m.paramName = obj["key"].toString();
-                m.value = measurementObj["value"].toDouble(-1.0);
-                m.dateTime = QDateTime::fromString(measurementObj["date"].toString(), Qt::ISODate);
-                measurements.append(m);
-            }
-            emit measurementsFetched(measurements);
+            emit measurementsFetched(sensorId, parseSensorData(reply->readAll()));
         } else {
             emit errorOccurred(reply->errorString());
         }
@@ -82,6 +71,29 @@ void AirQualityManager::fetchSensorData(int sensorId) {
     });
 }
 
+QList<Measurement> AirQualityManager::parseSensorData(const QByteArray &json) {
+    QList<Measurement> measurements;
+    QJsonDocument doc = QJsonDocument::fromJson(json);
+    QJsonObject obj = doc.object();
+    QString paramName = obj["key"].toString();
+    QJsonArray values = obj["values"].toArray();
+    measurements.reserve(values.size());
+    for (const QJsonValue &value : values) {
+        QJsonObject measurementObj = value.toObject();
+        Measurement m;
+        m.paramName = paramName;
+        // GIOŚ zwraca null dla brakujących pomiarów - zapisujemy je jako NaN
+        m.value = measurementObj["value"].toDouble(std::numeric_limits<double>::quiet_NaN());
+        QString date = measurementObj["date"].toString();
+        m.dateTime = QDateTime::fromString(date, Qt::ISODate);
+        if (!m.dateTime.isValid()) {
+            m.dateTime = QDateTime::fromString(date, "yyyy-MM-dd HH:mm:ss");
+        }
+        measurements.append(m);
+    }
+    return measurements;
+}
+
 void AirQualityManager::fetchCoordinates(const QString &address) {
     QUrl url("https://nominatim.openstreetmap.org/search");
     QUrlQuery query;
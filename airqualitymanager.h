@@ -43,10 +43,13 @@ public:
     /// @brief Pobiera współrzędne geograficzne dla podanego adresu.
     void fetchCoordinates(const QString &address);
 
+    /// @brief Parsuje odpowiedź z danymi pomiarowymi sensora (format /data/getData).
+    static QList<Measurement> parseSensorData(const QByteArray &json);
+
 signals:
     void stationsFetched(const QList<Station> &stations);
-    void sensorsFetched(const QList<Sensor> &sensors);
-    void measurementsFetched(const QList<Measurement> &measurements);
+    void sensorsFetched(int stationId, const QList<Sensor> &sensors);
+    void measurementsFetched(int sensorId, const QList<Measurement> &measurements);
     void coordinatesFetched(double latitude, double longitude);
     void errorOccurred(const QString &error);
 
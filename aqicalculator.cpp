@@ -0,0 +1,149 @@
+#include "AqiCalculator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+int AqiCalculator::pollutantIndex(const QString &paramName) {
+    for (int p = 0; p < int(kPollutants.size()); ++p) {
+        if (paramName.compare(QString::fromUtf8(kPollutants[p].code), Qt::CaseInsensitive) == 0 ||
+            paramName.compare(QString::fromUtf8(kPollutants[p].paramName), Qt::CaseInsensitive) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+int AqiCalculator::subIndex(int pollutant, double value) {
+    // Brak pomiaru: wartość ujemna (-1.0 z API) lub NaN
+    if (pollutant < 0 || !(value >= 0)) {
+        return -1;
+    }
+    // Próg jest górną granicą niższej klasy (PM10: 20.0 to jeszcze "Bardzo dobry")
+    int result = 0;
+    for (float bp : kPollutants[pollutant].breakpoints) {
+        result += (value > bp) ? 1 : 0;
+    }
+    return result;
+}
+
+QString AqiCalculator::categoryName(int index) {
+    switch (index) {
+    case 0: return "Bardzo dobry";
+    case 1: return "Dobry";
+    case 2: return "Umiarkowany";
+    case 3: return "Dostateczny";
+    case 4: return "Zły";
+    case 5: return "Bardzo zły";
+    default: return "Brak indeksu";
+    }
+}
+
+AqiGrid AqiCalculator::computeBatch(const QHash<int, QList<QList<Measurement>>> &seriesByStation,
+                                    const QDateTime &start, int hours) {
+    AqiGrid grid;
+    grid.start = start;
+    grid.hours = qMax(0, hours);
+    grid.stationIds = seriesByStation.keys();
+    std::sort(grid.stationIds.begin(), grid.stationIds.end());
+
+    const int rows = grid.stationIds.size();
+    const qsizetype cells = qsizetype(rows) * grid.hours;
+    grid.index.fill(-1, cells);
+    if (cells == 0) {
+        return grid;
+    }
+
+    // Stężenia każdego zanieczyszczenia na wspólnej siatce stacja x godzina (NaN = brak)
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::array<QVector<float>, kPollutants.size()> conc;
+    std::array<bool, kPollutants.size()> present {};
+    for (auto &c : conc) {
+        c.fill(nan, cells);
+    }
+
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 hourMs = 3600 * 1000;
+    for (int row = 0; row < rows; ++row) {
+        for (const auto &measurements : seriesByStation[grid.stationIds[row]]) {
+            if (measurements.isEmpty()) {
+                continue;
+            }
+            int p = pollutantIndex(measurements.first().paramName);
+            if (p < 0) {
+                continue;
+            }
+            present[p] = true;
+            float *dst = conc[p].data() + qsizetype(row) * grid.hours;
+            for (const auto &m : measurements) {
+                if (!(m.value >= 0)) {
+                    continue;
+                }
+                qint64 offset = m.dateTime.toMSecsSinceEpoch() - startMs;
+                if (offset < 0) {
+                    continue;
+                }
+                qint64 hour = offset / hourMs;
+                if (hour >= grid.hours) {
+                    continue;
+                }
+                // Kilka czujników tego samego parametru na stacji - bierzemy gorszy odczyt
+                float v = float(m.value);
+                if (!(dst[hour] >= v)) {
+                    dst[hour] = v;
+                }
+            }
+        }
+    }
+
+    for (int p = 0; p < int(kPollutants.size()); ++p) {
+        if (!present[p]) {
+            continue;
+        }
+        const float *values = conc[p].constData();
+
+        // Klasyfikacja bez rozgałęzień - pętla po ciągłej tablicy, wektoryzowana przez kompilator
+        const auto &bp = kPollutants[p].breakpoints;
+        qint8 *out = grid.index.data();
+        for (qsizetype i = 0; i < cells; ++i) {
+            const float v = values[i];
+            int sub = int(v > bp[0]) + int(v > bp[1]) + int(v > bp[2]) +
+                      int(v > bp[3]) + int(v > bp[4]);
+            sub = (v == v) ? sub : -1;
+            out[i] = qint8(qMax(int(out[i]), sub));
+        }
+    }
+
+    return grid;
+}
+
+AqiGrid AqiCalculator::computeBatch(const DataSnapshot &data, const QDateTime &start, int hours) {
+    QHash<int, QList<QList<Measurement>>> seriesByStation;
+    for (auto it = data.sensorsByStation.constBegin(); it != data.sensorsByStation.constEnd(); ++it) {
+        QList<QList<Measurement>> &stationSeries = seriesByStation[it.key()];
+        for (const auto &sensor : it.value()) {
+            auto series = data.seriesBySensor.constFind(sensor.id);
+            if (series != data.seriesBySensor.constEnd()) {
+                stationSeries.append(series.value());
+            }
+        }
+    }
+    return computeBatch(seriesByStation, start, hours);
+}
+
+QList<StationRank> AqiCalculator::rankStations(const AqiGrid &grid, int hour) {
+    QList<StationRank> ranking;
+    if (hour < 0 || hour >= grid.hours) {
+        return ranking;
+    }
+    ranking.reserve(grid.stationIds.size());
+    for (int row = 0; row < grid.stationIds.size(); ++row) {
+        ranking.append({ grid.stationIds[row], grid.at(row, hour) });
+    }
+    // Stacje bez indeksu trafiają na koniec rankingu
+    std::stable_sort(ranking.begin(), ranking.end(), [](const StationRank &a, const StationRank &b) {
+        int ka = (a.index < 0) ? std::numeric_limits<int>::max() : a.index;
+        int kb = (b.index < 0) ? std::numeric_limits<int>::max() : b.index;
+        return ka < kb;
+    });
+    return ranking;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QDateTime>
+#include <array>
+#include "DataRepository.h"
+
+/**
+ * @struct Pollutant
+ * @brief Opis zanieczyszczenia uwzględnianego w indeksie jakości powietrza.
+ */
+struct Pollutant {
+    const char *code;                 ///< Kod parametru GIOŚ (np. "PM10").
+    const char *paramName;            ///< Nazwa parametru zwracana przez API (Sensor::paramName).
+    const char *unit;                 ///< Jednostka stężenia.
+    std::array<float, 5> breakpoints; ///< Górne granice klas 0..4 (wartość równa progowi należy do niższej klasy).
+};
+
+/// @brief Tabela zanieczyszczeń i progów Polskiego Indeksu Jakości Powietrza (stężenia 1-godzinne).
+inline constexpr std::array<Pollutant, 5> kPollutants = {{
+    { "PM10",  "pył zawieszony PM10",  "µg/m3", {  20.0f,  50.0f,  80.0f, 110.0f, 150.0f } },
+    { "PM2.5", "pył zawieszony PM2.5", "µg/m3", {  13.0f,  35.0f,  55.0f,  75.0f, 110.0f } },
+    { "O3",    "ozon",                 "µg/m3", {  70.0f, 120.0f, 150.0f, 180.0f, 240.0f } },
+    { "NO2",   "dwutlenek azotu",      "µg/m3", {  40.0f, 100.0f, 150.0f, 230.0f, 400.0f } },
+    { "SO2",   "dwutlenek siarki",     "µg/m3", {  50.0f, 100.0f, 200.0f, 350.0f, 500.0f } },
+}};
+
+/**
+ * @struct AqiGrid
+ * @brief Indeksy jakości powietrza dla wszystkich stacji i godzin (wiersz = stacja).
+ */
+struct AqiGrid {
+    QDateTime start;       ///< Początek pierwszej godziny siatki.
+    int hours = 0;         ///< Liczba godzin w siatce.
+    QList<int> stationIds; ///< Identyfikatory stacji w kolejności wierszy.
+    QVector<qint8> index;  ///< Indeksy 0..5, -1 oznacza brak danych.
+
+    qint8 at(int row, int hour) const { return index[row * hours + hour]; }
+};
+
+/**
+ * @struct StationRank
+ * @brief Pozycja stacji w rankingu jakości powietrza.
+ */
+struct StationRank {
+    int stationId;
+    int index;
+};
+
+/**
+ * @class AqiCalculator
+ * @brief Oblicza indeks jakości powietrza dla całej sieci stacji.
+ */
+class AqiCalculator {
+public:
+    /// @brief Zwraca pozycję zanieczyszczenia w kPollutants dla kodu lub nazwy parametru (-1 gdy nieznane).
+    static int pollutantIndex(const QString &paramName);
+
+    /// @brief Zwraca indeks cząstkowy (0..5) dla stężenia lub -1 gdy brak pomiaru.
+    static int subIndex(int pollutant, double value);
+
+    /// @brief Zwraca nazwę kategorii indeksu.
+    static QString categoryName(int index);
+
+    /**
+     * @brief Oblicza indeksy dla wszystkich stacji i godzin jednym przebiegiem.
+     * @param seriesByStation Serie pomiarowe czujników pogrupowane według id stacji.
+     * @param start Początek siatki godzinowej.
+     * @param hours Liczba godzin.
+     */
+    static AqiGrid computeBatch(const QHash<int, QList<QList<Measurement>>> &seriesByStation,
+                                const QDateTime &start, int hours);
+
+    /// @brief Oblicza indeksy dla wszystkich stacji zapisanych w migawce repozytorium.
+    static AqiGrid computeBatch(const DataSnapshot &data, const QDateTime &start, int hours);
+
+    /// @brief Zwraca stacje posortowane od najlepszej jakości powietrza w danej godzinie siatki.
+    static QList<StationRank> rankStations(const AqiGrid &grid, int hour);
+};
@@ -0,0 +1,356 @@
+#include "BackfillPipeline.h"
+#include "StreamingExporter.h"
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+/// Dołącza pomiary do serii w kolejności czasu; dla powtórzonych godzin zostaje nowsza wartość.
+void mergeSeries(QList<Measurement> &series, QList<Measurement> measurements) {
+    if (measurements.isEmpty()) {
+        return;
+    }
+    std::stable_sort(measurements.begin(), measurements.end(), [](const Measurement &a, const Measurement &b) {
+        return a.dateTime < b.dateTime;
+    });
+    if (series.isEmpty() || series.last().dateTime < measurements.first().dateTime) {
+        series.append(measurements);
+        return;
+    }
+
+    series.append(measurements);
+    std::stable_sort(series.begin(), series.end(), [](const Measurement &a, const Measurement &b) {
+        return a.dateTime < b.dateTime;
+    });
+    QList<Measurement> merged;
+    merged.reserve(series.size());
+    for (const auto &m : series) {
+        if (!merged.isEmpty() && merged.last().dateTime == m.dateTime) {
+            merged.last() = m;
+        } else {
+            merged.append(m);
+        }
+    }
+    series = merged;
+}
+
+} // namespace
+
+BackfillPipeline::BackfillPipeline(DataRepository *repository, QObject *parent)
+    : QObject(parent), repository(repository) {
+    networkManager = new QNetworkAccessManager(this);
+}
+
+void BackfillPipeline::start(const QList<int> &sensorIds, const QDateTime &from, const QDateTime &to) {
+    if (running) {
+        return;
+    }
+    if (endpoint.isEmpty()) {
+        emit errorOccurred("Nie ustawiono adresu archiwum danych.");
+        return;
+    }
+    stats = BackfillStats();
+    ready.clear();
+    inFlight = 0;
+    nextRequestAt = 0;
+    rangeEnd = to;
+
+    loadStoredData();
+
+    // Stacja sensora trafia do pliku danych; bez niej seria nie byłaby widoczna
+    // w sensorsByStation (indeks, korelacje, eksport)
+    stationBySensor.clear();
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    for (auto it = data->sensorsByStation.constBegin(); it != data->sensorsByStation.constEnd(); ++it) {
+        for (const auto &sensor : it.value()) {
+            stationBySensor.insert(sensor.id, it.key());
+        }
+    }
+    QList<int> knownSensorIds;
+    for (int sensorId : sensorIds) {
+        if (stationBySensor.contains(sensorId)) {
+            knownSensorIds.append(sensorId);
+        } else {
+            emit errorOccurred(QString("Sensor %1 nie jest przypisany do żadnej stacji w repozytorium.").arg(sensorId));
+        }
+    }
+
+    // Bez pliku danych punkty kontrolne wskazywałyby porcje, których nigdzie nie zapisano
+    dataFile.setFileName(dataFileName);
+    if (!dataFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        emit errorOccurred("Nie udało się otworzyć pliku danych: " + dataFileName);
+        return;
+    }
+
+    loadCheckpoints();
+    for (int sensorId : knownSensorIds) {
+        const QDateTime next = firstUncovered(sensorId, from);
+        if (next < to) {
+            ready.enqueue({ sensorId, next, 0 });
+        }
+    }
+
+    running = true;
+    clock.start();
+    QMetaObject::invokeMethod(this, &BackfillPipeline::schedule, Qt::QueuedConnection);
+}
+
+void BackfillPipeline::cancel() {
+    if (!running) {
+        return;
+    }
+    finish();
+    // finish() zmienia numer przebiegu, więc przerwane odpowiedzi nie zmienią już stanu
+    const QSet<QNetworkReply*> aborted = replies;
+    replies.clear();
+    for (QNetworkReply *reply : aborted) {
+        reply->abort();
+    }
+}
+
+void BackfillPipeline::schedule() {
+    if (!running) {
+        return;
+    }
+    while (inFlight < maxConcurrent && !ready.isEmpty()) {
+        // Globalny limit zapytań: kolejne zapytanie najwcześniej po 1/rate sekundy
+        const qint64 now = clock.nsecsElapsed();
+        if (now < nextRequestAt) {
+            if (!timerPending) {
+                timerPending = true;
+                const int delayMs = int((nextRequestAt - now + 999999) / 1000000);
+                QTimer::singleShot(delayMs, this, [this]() {
+                    timerPending = false;
+                    schedule();
+                });
+            }
+            return;
+        }
+        nextRequestAt = now + qint64(1e9 / requestsPerSecond);
+        dispatch(ready.dequeue());
+    }
+    if (ready.isEmpty() && inFlight == 0) {
+        finish();
+    }
+}
+
+void BackfillPipeline::dispatch(SensorTask task) {
+    const QDateTime end = chunkEnd(task);
+    QUrl url(endpoint.arg(task.sensorId)
+                 .arg(task.next.toString(Qt::ISODate))
+                 .arg(end.addSecs(-1).toString(Qt::ISODate)));
+
+    QNetworkReply *reply = networkManager->get(QNetworkRequest(url));
+    replies.insert(reply);
+    inFlight++;
+    stats.requests++;
+    const quint64 run = generation;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, task, end, run]() mutable {
+        reply->deleteLater();
+        replies.remove(reply);
+        if (run != generation) {
+            return;
+        }
+        inFlight--;
+
+        if (reply->error() == QNetworkReply::NoError) {
+            if (!store(task.sensorId, AirQualityManager::parseSensorData(reply->readAll()))) {
+                emit errorOccurred("Nie udało się zapisać danych w pliku: " + dataFileName);
+                cancel();
+                return;
+            }
+            addCoverage(task.sensorId, task.next, end);
+            saveCheckpoints();
+            emit progress(stats.points, stats.points * 1000.0 / qMax<qint64>(1, clock.elapsed()));
+            const QDateTime next = firstUncovered(task.sensorId, end);
+            if (next < rangeEnd) {
+                ready.enqueue({ task.sensorId, next, 0 });
+            } else {
+                publishPending({ task.sensorId });
+            }
+        } else if (++task.attempts < maxAttempts) {
+            ready.enqueue(task);
+        } else {
+            publishPending({ task.sensorId });
+            stats.failedSensors++;
+            emit errorOccurred(QString("Nie udało się pobrać danych sensora %1: %2")
+                                   .arg(task.sensorId).arg(reply->errorString()));
+        }
+        schedule();
+    });
+}
+
+bool BackfillPipeline::store(int sensorId, QList<Measurement> measurements) {
+    if (measurements.isEmpty()) {
+        return true;
+    }
+    // Najpierw plik danych, potem punkt kontrolny - po awarii porcja zostanie pobrana ponownie
+    ExportStats written = StreamingExporter::appendCsv(&dataFile, stationBySensor.value(sensorId, -1),
+                                                       sensorId, measurements);
+    if (!written.ok || !dataFile.flush()) {
+        return false;
+    }
+    stats.points += measurements.size();
+
+    // Każda publikacja kopiuje całą historię sensora (seria jest współdzielona z poprzednią
+    // migawką), więc porcje trafiają do repozytorium w paczkach
+    pending[sensorId].append(measurements);
+    if (++pendingChunks[sensorId] >= publishInterval) {
+        publishPending({ sensorId });
+    }
+    return true;
+}
+
+void BackfillPipeline::publishPending(const QList<int> &sensorIds) {
+    QHash<int, QList<Measurement>> batch;
+    for (int sensorId : sensorIds) {
+        auto it = pending.find(sensorId);
+        if (it != pending.end()) {
+            batch.insert(sensorId, it.value());
+            pending.erase(it);
+        }
+        pendingChunks.remove(sensorId);
+    }
+    if (batch.isEmpty()) {
+        return;
+    }
+    repository->update([&batch](DataSnapshot &data) {
+        for (auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+            mergeSeries(data.seriesBySensor[it.key()], it.value());
+        }
+    });
+}
+
+void BackfillPipeline::addCoverage(int sensorId, const QDateTime &start, const QDateTime &done) {
+    QList<BackfillInterval> &intervals = checkpoints[sensorId];
+    BackfillInterval added { start, done };
+    QList<BackfillInterval> merged;
+    bool inserted = false;
+    for (const auto &interval : intervals) {
+        if (interval.done < added.start) {
+            merged.append(interval);
+        } else if (interval.start > added.done) {
+            if (!inserted) {
+                merged.append(added);
+                inserted = true;
+            }
+            merged.append(interval);
+        } else {
+            // Przedziały nachodzą na siebie lub się stykają
+            added.start = qMin(added.start, interval.start);
+            added.done = qMax(added.done, interval.done);
+        }
+    }
+    if (!inserted) {
+        merged.append(added);
+    }
+    intervals = merged;
+}
+
+QDateTime BackfillPipeline::firstUncovered(int sensorId, QDateTime from) const {
+    for (const auto &interval : checkpoints.value(sensorId)) {
+        if (interval.start <= from && from < interval.done) {
+            from = interval.done;
+        }
+    }
+    return from;
+}
+
+QDateTime BackfillPipeline::chunkEnd(const SensorTask &task) const {
+    QDateTime end = qMin(task.next.addDays(chunkDays), rangeEnd);
+    // Porcja kończy się na początku już pobranego przedziału
+    for (const auto &interval : checkpoints.value(task.sensorId)) {
+        if (interval.start > task.next && interval.start < end) {
+            end = interval.start;
+        }
+    }
+    return end;
+}
+
+void BackfillPipeline::loadStoredData() {
+    QFile file(dataFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QHash<int, int> storedStations;
+    QHash<int, QList<Measurement>> stored = StreamingExporter::readCsv(&file, &storedStations);
+    if (stored.isEmpty()) {
+        return;
+    }
+    repository->update([&stored, &storedStations](DataSnapshot &data) {
+        for (auto it = stored.constBegin(); it != stored.constEnd(); ++it) {
+            mergeSeries(data.seriesBySensor[it.key()], it.value());
+
+            // Przywraca przypisanie sensora do stacji, jeśli repozytorium go jeszcze nie zna
+            const int stationId = storedStations.value(it.key(), -1);
+            if (stationId < 0) {
+                continue;
+            }
+            QList<Sensor> &sensors = data.sensorsByStation[stationId];
+            const bool known = std::any_of(sensors.cbegin(), sensors.cend(), [&it](const Sensor &sensor) {
+                return sensor.id == it.key();
+            });
+            if (!known) {
+                sensors.append({ it.key(), it.value().first().paramName });
+            }
+        }
+    });
+}
+
+void BackfillPipeline::loadCheckpoints() {
+    checkpoints.clear();
+    QFile file(checkpointFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    // Format: {"<id sensora>": [{"start": ISO, "done": ISO}, ...]}
+    QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
+        const int sensorId = it.key().toInt();
+        for (const QJsonValue &value : it.value().toArray()) {
+            const QJsonObject item = value.toObject();
+            QDateTime start = QDateTime::fromString(item["start"].toString(), Qt::ISODate);
+            QDateTime done = QDateTime::fromString(item["done"].toString(), Qt::ISODate);
+            if (start.isValid() && done.isValid() && start < done) {
+                addCoverage(sensorId, start, done);
+            }
+        }
+    }
+}
+
+void BackfillPipeline::saveCheckpoints() {
+    QJsonObject obj;
+    for (auto it = checkpoints.constBegin(); it != checkpoints.constEnd(); ++it) {
+        QJsonArray intervals;
+        for (const auto &interval : it.value()) {
+            QJsonObject item;
+            item["start"] = interval.start.toString(Qt::ISODate);
+            item["done"] = interval.done.toString(Qt::ISODate);
+            intervals.append(item);
+        }
+        obj[QString::number(it.key())] = intervals;
+    }
+    // QSaveFile podmienia plik atomowo, więc przerwany zapis nie uszkodzi punktów kontrolnych
+    QSaveFile file(checkpointFile);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+        file.commit();
+    } else {
+        emit errorOccurred("Nie udało się zapisać punktów kontrolnych: " + checkpointFile);
+    }
+}
+
+void BackfillPipeline::finish() {
+    publishPending(pending.keys());
+    running = false;
+    generation++;
+    dataFile.close();
+    stats.elapsedMs = clock.elapsed();
+    stats.pointsPerSecond = stats.points * 1000.0 / qMax<qint64>(1, stats.elapsedMs);
+    emit finished(stats);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QFile>
+#include "DataRepository.h"
+
+/**
+ * @struct BackfillStats
+ * @brief Podsumowanie pobierania danych historycznych.
+ */
+struct BackfillStats {
+    qint64 points = 0;         ///< Liczba zapisanych pomiarów.
+    qint64 requests = 0;       ///< Liczba wykonanych zapytań.
+    qint64 failedSensors = 0;  ///< Sensory przerwane po wyczerpaniu prób.
+    qint64 elapsedMs = 0;
+    double pointsPerSecond = 0.0;
+};
+Q_DECLARE_METATYPE(BackfillStats)
+
+/**
+ * @struct BackfillInterval
+ * @brief Przedział [start, done) pobrany i zapisany w pliku danych.
+ */
+struct BackfillInterval {
+    QDateTime start;
+    QDateTime done;
+};
+
+/**
+ * @class BackfillPipeline
+ * @brief Pobiera dane archiwalne sensorów porcjami i zapisuje je w DataRepository.
+ *
+ * Zakres dat każdego sensora jest dzielony na porcje pobierane kolejno. Każda porcja
+ * jest dopisywana do pliku danych (CSV); dopiero po udanym zapisie jej przedział
+ * dołączany jest do pokrycia sensora w pliku punktów kontrolnych. Do repozytorium porcje
+ * trafiają w paczkach (setPublishInterval()) oraz po zakończeniu zakresu sensora.
+ * Ponowne uruchomienie wczytuje plik danych i pobiera tylko niepokryte części zakresu,
+ * także gdy nowy zakres zaczyna się wcześniej niż poprzedni. Wiele sensorów jest
+ * pobieranych równolegle przy wspólnym limicie liczby zapytań na sekundę.
+ */
+class BackfillPipeline : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BackfillPipeline(DataRepository *repository, QObject *parent = nullptr);
+
+    /**
+     * @brief Ustawia adres archiwum (wymagany przed start()).
+     * @param urlTemplate Szablon adresu: %1 - id sensora, %2 - początek, %3 - koniec porcji (ISO 8601).
+     *        Odpowiedź musi mieć format /pjp-api/rest/data/getData.
+     */
+    void setEndpoint(const QString &urlTemplate) { endpoint = urlTemplate; }
+
+    /// @brief Ustawia plik punktów kontrolnych.
+    void setCheckpointFile(const QString &fileName) { checkpointFile = fileName; }
+
+    /// @brief Ustawia plik danych, do którego dopisywane są pobrane porcje.
+    void setDataFile(const QString &fileName) { dataFileName = fileName; }
+
+    /// @brief Ustawia długość porcji w dniach.
+    void setChunkDays(int days) { chunkDays = qMax(1, days); }
+
+    /// @brief Ustawia maksymalną liczbę równoczesnych zapytań.
+    void setMaxConcurrentRequests(int count) { maxConcurrent = qMax(1, count); }
+
+    /// @brief Ustawia globalny limit zapytań na sekundę.
+    void setRequestsPerSecond(double rate) { requestsPerSecond = qMax(0.01, rate); }
+
+    /// @brief Ustawia, co ile zapisanych porcji sensora dane są publikowane w repozytorium.
+    void setPublishInterval(int chunks) { publishInterval = qMax(1, chunks); }
+
+    /// @brief Ustawia liczbę prób pobrania porcji.
+    void setMaxAttempts(int attempts) { maxAttempts = qMax(1, attempts); }
+
+    /**
+     * @brief Rozpoczyna pobieranie zakresu [from, to) dla podanych sensorów.
+     *
+     * Sensory muszą być przypisane do stacji w repozytorium (publishSensors) lub w pliku
+     * danych z poprzedniego przebiegu; pozostałe są pomijane z errorOccurred().
+     */
+    void start(const QList<int> &sensorIds, const QDateTime &from, const QDateTime &to);
+
+    /// @brief Przerywa pobieranie i zapytania w toku (zapisany postęp zostaje zachowany).
+    void cancel();
+
+    bool isRunning() const { return running; }
+
+    /// @brief Zwraca rozłączne, posortowane przedziały pobrane dla sensora (z pliku punktów kontrolnych).
+    QList<BackfillInterval> coverage(int sensorId) const { return checkpoints.value(sensorId); }
+
+signals:
+    void progress(qint64 points, double pointsPerSecond);
+    void finished(const BackfillStats &stats);
+    void errorOccurred(const QString &error);
+
+private:
+    struct SensorTask {
+        int sensorId;
+        QDateTime next;
+        int attempts;
+    };
+
+    void schedule();
+    void dispatch(SensorTask task);
+    bool store(int sensorId, QList<Measurement> measurements);
+    void publishPending(const QList<int> &sensorIds);
+    void addCoverage(int sensorId, const QDateTime &start, const QDateTime &done);
+    QDateTime firstUncovered(int sensorId, QDateTime from) const;
+    QDateTime chunkEnd(const SensorTask &task) const;
+    void loadStoredData();
+    void loadCheckpoints();
+    void saveCheckpoints();
+    void finish();
+
+    DataRepository *repository;
+    QNetworkAccessManager *networkManager;
+
+    QString endpoint;
+    QString checkpointFile = "backfill_checkpoint.json";
+    QString dataFileName = "backfill_data.csv";
+    int chunkDays = 7;
+    int maxConcurrent = 8;
+    double requestsPerSecond = 5.0;
+    int maxAttempts = 3;
+    int publishInterval = 16;
+
+    QDateTime rangeEnd;
+    QQueue<SensorTask> ready;
+    QHash<int, QList<BackfillInterval>> checkpoints;
+    QHash<int, int> stationBySensor;
+    QHash<int, QList<Measurement>> pending; ///< Zapisane w pliku, jeszcze nieopublikowane porcje.
+    QHash<int, int> pendingChunks;
+    QSet<QNetworkReply*> replies;
+    QFile dataFile;
+    int inFlight = 0;
+    quint64 generation = 0; ///< Numer przebiegu; odpowiedzi z przerwanego przebiegu są pomijane.
+    bool running = false;
+    bool timerPending = false;
+    qint64 nextRequestAt = 0; ///< W nanosekundach zegara clock.
+    QElapsedTimer clock;
+    BackfillStats stats;
+};
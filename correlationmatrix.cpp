@@ -0,0 +1,331 @@
+#include "CorrelationMatrix.h"
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int kLanes = 8;        ///< Szerokość akumulatorów (wektor 8 x float).
+const int kRowBlock = 32;    ///< Liczba wierszy w bloku macierzy.
+const int kHourBlock = 1024; ///< Liczba godzin przetwarzana naraz (blok danych w L1/L2).
+
+/// Dane przygotowane do obliczeń: wartości wycentrowane (0 w lukach) i maska obecności.
+struct PreparedRows {
+    int rows = 0;
+    int stride = 0;
+    QVector<float> x;
+    QVector<float> mask;
+    QVector<int> validCount;
+    QVector<int> maskGroup; ///< Wiersze o identycznych lukach mają ten sam numer grupy.
+};
+
+/// Zamienia wartości wiersza na rangi (remisy otrzymują średnią rangę), luki pozostają NaN.
+void rankRow(QVector<float> &line) {
+    QVector<int> order;
+    order.reserve(line.size());
+    for (int h = 0; h < line.size(); ++h) {
+        if (line[h] == line[h]) {
+            order.append(h);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&line](int a, int b) { return line[a] < line[b]; });
+
+    for (int i = 0; i < order.size();) {
+        int j = i;
+        while (j + 1 < order.size() && line[order[j + 1]] == line[order[i]]) {
+            ++j;
+        }
+        const float rank = 0.5f * float(i + j) + 1.0f;
+        for (int k = i; k <= j; ++k) {
+            line[order[k]] = rank;
+        }
+        i = j + 1;
+    }
+}
+
+PreparedRows prepare(const HourlyGrid &grid, CorrelationMatrix::Method method) {
+    PreparedRows p;
+    p.rows = grid.ids.size();
+    p.stride = (grid.hours + kLanes - 1) / kLanes * kLanes;
+    p.x.fill(0.0f, qsizetype(p.rows) * p.stride);
+    p.mask.fill(0.0f, qsizetype(p.rows) * p.stride);
+    p.validCount.fill(0, p.rows);
+    p.maskGroup.fill(0, p.rows);
+    QHash<QByteArray, int> groups;
+
+    QVector<float> line(grid.hours);
+    for (int row = 0; row < p.rows; ++row) {
+        const float *src = grid.values.constData() + qsizetype(row) * grid.hours;
+        std::copy(src, src + grid.hours, line.begin());
+        if (method == CorrelationMatrix::Method::Spearman) {
+            // Rangi na godzinach wiersza są poprawne tylko dla par o tych samych lukach
+            QByteArray present(grid.hours, '\0');
+            for (int h = 0; h < grid.hours; ++h) {
+                present[h] = (line[h] == line[h]) ? 1 : 0;
+            }
+            p.maskGroup[row] = groups.value(present, int(groups.size()));
+            groups.insert(present, p.maskGroup[row]);
+            rankRow(line);
+        }
+
+        double sum = 0.0;
+        int count = 0;
+        for (float v : line) {
+            if (v == v) {
+                sum += v;
+                count++;
+            }
+        }
+        // Centrowanie poprawia dokładność sum w pojedynczej precyzji
+        const float mean = (count > 0) ? float(sum / count) : 0.0f;
+        float *x = p.x.data() + qsizetype(row) * p.stride;
+        float *mask = p.mask.data() + qsizetype(row) * p.stride;
+        for (int h = 0; h < grid.hours; ++h) {
+            if (line[h] == line[h]) {
+                x[h] = line[h] - mean;
+                mask[h] = 1.0f;
+            }
+        }
+        p.validCount[row] = count;
+    }
+    return p;
+}
+
+/**
+ * Sumy dla pary wierszy na wspólnych godzinach: n, Sx, Sy, Sxx, Syy, Sxy.
+ * Pętla wewnętrzna działa na kLanes niezależnych akumulatorach, więc kompilator
+ * może ją zwektoryzować bez zmiany kolejności sumowania.
+ */
+inline void accumulatePair(const float *xi, const float *mi, const float *xj, const float *mj,
+                           int t0, int t1, double *acc) {
+    float n[kLanes] = {}, sx[kLanes] = {}, sy[kLanes] = {};
+    float sxx[kLanes] = {}, syy[kLanes] = {}, sxy[kLanes] = {};
+    for (int t = t0; t < t1; t += kLanes) {
+        for (int k = 0; k < kLanes; ++k) {
+            const float a = xi[t + k];
+            const float b = xj[t + k];
+            const float ma = mi[t + k];
+            const float mb = mj[t + k];
+            n[k] += ma * mb;
+            sx[k] += a * mb;
+            sy[k] += b * ma;
+            sxx[k] += a * a * mb;
+            syy[k] += b * b * ma;
+            sxy[k] += a * b;
+        }
+    }
+    for (int k = 0; k < kLanes; ++k) {
+        acc[0] += n[k];
+        acc[1] += sx[k];
+        acc[2] += sy[k];
+        acc[3] += sxx[k];
+        acc[4] += syy[k];
+        acc[5] += sxy[k];
+    }
+}
+
+float correlationFromSums(const double *acc, int minOverlap) {
+    const double n = acc[0];
+    if (n < minOverlap) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    const double cov = acc[5] - acc[1] * acc[2] / n;
+    const double vx = acc[3] - acc[1] * acc[1] / n;
+    const double vy = acc[4] - acc[2] * acc[2] / n;
+    if (vx <= 0.0 || vy <= 0.0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    return float(qBound(-1.0, cov / std::sqrt(vx * vy), 1.0));
+}
+
+/**
+ * Dokładny współczynnik Spearmana pary wierszy o różnych lukach: rangi liczone są
+ * od nowa tylko na godzinach wspólnych.
+ */
+float spearmanOnCommonHours(const float *a, const float *b, int hours, int minOverlap) {
+    QVector<float> ra;
+    QVector<float> rb;
+    for (int h = 0; h < hours; ++h) {
+        if (a[h] == a[h] && b[h] == b[h]) {
+            ra.append(a[h]);
+            rb.append(b[h]);
+        }
+    }
+    if (ra.size() < minOverlap) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    rankRow(ra);
+    rankRow(rb);
+    double acc[6] = { double(ra.size()), 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (int k = 0; k < ra.size(); ++k) {
+        acc[1] += ra[k];
+        acc[2] += rb[k];
+        acc[3] += double(ra[k]) * ra[k];
+        acc[4] += double(rb[k]) * rb[k];
+        acc[5] += double(ra[k]) * rb[k];
+    }
+    return correlationFromSums(acc, minOverlap);
+}
+
+} // namespace
+
+HourlyGrid CorrelationMatrix::alignHourly(const QHash<int, QList<Measurement>> &seriesById,
+                                          const QDateTime &start, int hours) {
+    HourlyGrid grid;
+    grid.start = start;
+    grid.hours = qMax(0, hours);
+    grid.ids = seriesById.keys();
+    std::sort(grid.ids.begin(), grid.ids.end());
+
+    const qsizetype cells = qsizetype(grid.ids.size()) * grid.hours;
+    grid.values.fill(0.0f, cells);
+    QVector<int> counts(cells, 0);
+
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 hourMs = 3600 * 1000;
+    for (int row = 0; row < grid.ids.size(); ++row) {
+        float *sum = grid.values.data() + qsizetype(row) * grid.hours;
+        int *count = counts.data() + qsizetype(row) * grid.hours;
+        for (const auto &m : seriesById[grid.ids[row]]) {
+            // Luki (null z API) są przechowywane jako NaN, starsze dane jako wartość ujemna
+            if (!(m.value >= 0)) {
+                continue;
+            }
+            qint64 offset = m.dateTime.toMSecsSinceEpoch() - startMs;
+            if (offset < 0 || offset / hourMs >= grid.hours) {
+                continue;
+            }
+            sum[offset / hourMs] += float(m.value);
+            count[offset / hourMs]++;
+        }
+    }
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (qsizetype i = 0; i < cells; ++i) {
+        grid.values[i] = (counts[i] > 0) ? grid.values[i] / counts[i] : nan;
+    }
+    return grid;
+}
+
+HourlyGrid CorrelationMatrix::alignHourly(const DataSnapshot &data, const QString &paramCode,
+                                          const QDateTime &start, int hours) {
+    QHash<int, QList<Measurement>> seriesByStation;
+    for (auto it = data.sensorsByStation.constBegin(); it != data.sensorsByStation.constEnd(); ++it) {
+        for (const auto &sensor : it.value()) {
+            const QList<Measurement> series = data.seriesBySensor.value(sensor.id);
+            if (series.isEmpty()) {
+                continue;
+            }
+            if (series.first().paramName.compare(paramCode, Qt::CaseInsensitive) == 0 ||
+                sensor.paramName.compare(paramCode, Qt::CaseInsensitive) == 0) {
+                seriesByStation.insert(it.key(), series);
+                break;
+            }
+        }
+    }
+    return alignHourly(seriesByStation, start, hours);
+}
+
+CorrelationResult CorrelationMatrix::compute(const HourlyGrid &grid, Method method, int minOverlap, int threads) {
+    const PreparedRows p = prepare(grid, method);
+    const int n = p.rows;
+
+    CorrelationResult result;
+    result.ids = grid.ids;
+    result.matrix.fill(std::numeric_limits<float>::quiet_NaN(), qsizetype(n) * n);
+    for (int i = 0; i < n; ++i) {
+        if (p.validCount[i] >= minOverlap) {
+            result.matrix[qsizetype(i) * n + i] = 1.0f;
+        }
+    }
+
+    // Bloki (bi, bj) górnego trójkąta; każdy blok zapisuje rozłączne komórki macierzy
+    const int blocks = (n + kRowBlock - 1) / kRowBlock;
+    QVector<QPair<int, int>> tiles;
+    for (int bi = 0; bi < blocks; ++bi) {
+        for (int bj = bi; bj < blocks; ++bj) {
+            tiles.append({ bi, bj });
+        }
+    }
+
+    // Spearman: pary o różnych lukach liczone są osobno, z rangami na wspólnych godzinach
+    const bool spearman = (method == Method::Spearman);
+    auto sameMask = [&](int i, int j) { return !spearman || p.maskGroup[i] == p.maskGroup[j]; };
+
+    float *matrix = result.matrix.data();
+    auto processTile = [&](int bi, int bj) {
+        const int i0 = bi * kRowBlock, i1 = qMin(n, i0 + kRowBlock);
+        const int j0 = bj * kRowBlock, j1 = qMin(n, j0 + kRowBlock);
+        double acc[kRowBlock * kRowBlock * 6] = {};
+
+        for (int t0 = 0; t0 < p.stride; t0 += kHourBlock) {
+            const int t1 = qMin(p.stride, t0 + kHourBlock);
+            for (int i = i0; i < i1; ++i) {
+                const float *xi = p.x.constData() + qsizetype(i) * p.stride;
+                const float *mi = p.mask.constData() + qsizetype(i) * p.stride;
+                for (int j = (bi == bj) ? i + 1 : j0; j < j1; ++j) {
+                    const float *xj = p.x.constData() + qsizetype(j) * p.stride;
+                    const float *mj = p.mask.constData() + qsizetype(j) * p.stride;
+                    if (!sameMask(i, j)) {
+                        continue;
+                    }
+                    accumulatePair(xi, mi, xj, mj, t0, t1, acc + ((i - i0) * kRowBlock + (j - j0)) * 6);
+                }
+            }
+        }
+
+        for (int i = i0; i < i1; ++i) {
+            for (int j = (bi == bj) ? i + 1 : j0; j < j1; ++j) {
+                const float r = sameMask(i, j)
+                    ? correlationFromSums(acc + ((i - i0) * kRowBlock + (j - j0)) * 6, minOverlap)
+                    : spearmanOnCommonHours(grid.values.constData() + qsizetype(i) * grid.hours,
+                                            grid.values.constData() + qsizetype(j) * grid.hours,
+                                            grid.hours, minOverlap);
+                matrix[qsizetype(i) * n + j] = r;
+                matrix[qsizetype(j) * n + i] = r;
+            }
+        }
+    };
+
+    QAtomicInt nextTile(0);
+    auto worker = [&]() {
+        for (int k = nextTile.fetchAndAddRelaxed(1); k < tiles.size(); k = nextTile.fetchAndAddRelaxed(1)) {
+            processTile(tiles[k].first, tiles[k].second);
+        }
+    };
+
+    const int workerCount = qBound(1, threads, qMax(1, int(tiles.size())));
+    if (workerCount == 1) {
+        worker();
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(workerCount);
+        for (int w = 0; w < workerCount; ++w) {
+            pool.start(worker);
+        }
+        pool.waitForDone();
+    }
+    return result;
+}
+
+QList<int> CorrelationMatrix::outliers(const CorrelationResult &result, float threshold) {
+    QList<int> ids;
+    const int n = result.ids.size();
+    for (int i = 0; i < n; ++i) {
+        double sum = 0.0;
+        int count = 0;
+        for (int j = 0; j < n; ++j) {
+            const float r = result.at(i, j);
+            if (j != i && r == r) {
+                sum += r;
+                count++;
+            }
+        }
+        if (count > 0 && sum / count < threshold) {
+            ids.append(result.ids[i]);
+        }
+    }
+    return ids;
+}
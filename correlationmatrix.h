@@ -0,0 +1,67 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QDateTime>
+#include <QThread>
+#include "DataRepository.h"
+
+/**
+ * @struct HourlyGrid
+ * @brief Serie pomiarowe wyrównane do wspólnej siatki godzinowej (wiersz = seria).
+ */
+struct HourlyGrid {
+    QDateTime start;      ///< Początek pierwszej godziny.
+    int hours = 0;        ///< Liczba godzin.
+    QList<int> ids;       ///< Identyfikatory serii w kolejności wierszy (np. id stacji).
+    QVector<float> values; ///< ids.size() * hours wartości, NaN oznacza brak pomiaru.
+
+    float at(int row, int hour) const { return values[qsizetype(row) * hours + hour]; }
+};
+
+/**
+ * @struct CorrelationResult
+ * @brief Symetryczna macierz korelacji N x N (NaN, gdy za mało wspólnych pomiarów).
+ */
+struct CorrelationResult {
+    QList<int> ids;
+    QVector<float> matrix;
+
+    float at(int i, int j) const { return matrix[qsizetype(i) * ids.size() + j]; }
+};
+
+/**
+ * @class CorrelationMatrix
+ * @brief Oblicza korelacje Pearsona i Spearmana między seriami wielu stacji.
+ *
+ * Korelacje liczone są na parach wspólnych (obu obecnych) godzin. Obliczenia są
+ * podzielone na bloki wierszy i godzin mieszczące się w pamięci podręcznej procesora
+ * i wykonywane równolegle na puli wątków.
+ *
+ * Spearman: wiersze o identycznych lukach są rangowane raz i liczone w blokach jak
+ * Pearson; dla par o różnych lukach rangi wyznaczane są od nowa na godzinach wspólnych,
+ * więc wynik jest zawsze dokładnym współczynnikiem Spearmana dla tych godzin.
+ */
+class CorrelationMatrix {
+public:
+    enum class Method { Pearson, Spearman };
+
+    /// @brief Wyrównuje serie do siatki godzinowej; kilka pomiarów w godzinie jest uśrednianych.
+    static HourlyGrid alignHourly(const QHash<int, QList<Measurement>> &seriesById,
+                                  const QDateTime &start, int hours);
+
+    /// @brief Wyrównuje serie danego parametru (np. "PM10") dla wszystkich stacji z migawki.
+    static HourlyGrid alignHourly(const DataSnapshot &data, const QString &paramCode,
+                                  const QDateTime &start, int hours);
+
+    /**
+     * @brief Oblicza macierz korelacji dla wszystkich par wierszy siatki.
+     * @param minOverlap Minimalna liczba wspólnych godzin pary.
+     * @param threads Liczba wątków roboczych.
+     */
+    static CorrelationResult compute(const HourlyGrid &grid, Method method = Method::Pearson,
+                                     int minOverlap = 3, int threads = QThread::idealThreadCount());
+
+    /// @brief Zwraca id serii, których średnia korelacja z pozostałymi jest niższa niż próg.
+    static QList<int> outliers(const CorrelationResult &result, float threshold);
+};
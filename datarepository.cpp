@@ -0,0 +1,26 @@
+#include "DataRepository.h"
+
+DataRepository::DataRepository(QObject *parent)
+    : QObject(parent), current(std::make_shared<const DataSnapshot>()) {}
+
+std::shared_ptr<const DataSnapshot> DataRepository::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void DataRepository::publishStations(const QList<Station> &stations) {
+    update([&stations](DataSnapshot &data) {
+        data.stations = stations;
+    });
+}
+
+void DataRepository::publishSensors(int stationId, const QList<Sensor> &sensors) {
+    update([stationId, &sensors](DataSnapshot &data) {
+        data.sensorsByStation[stationId] = sensors;
+    });
+}
+
+void DataRepository::publishMeasurements(int sensorId, const QList<Measurement> &measurements) {
+    update([sensorId, &measurements](DataSnapshot &data) {
+        data.seriesBySensor[sensorId] = measurements;
+    });
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <memory>
+#include "AirQualityManager.h"
+
+/**
+ * @struct DataSnapshot
+ * @brief Niezmienna wersja danych o stacjach, sensorach i pomiarach.
+ */
+struct DataSnapshot {
+    quint64 version = 0;
+    QList<Station> stations;
+    QHash<int, QList<Sensor>> sensorsByStation;
+    QHash<int, QList<Measurement>> seriesBySensor;
+};
+
+/**
+ * @class DataRepository
+ * @brief Repozytorium danych współdzielone między wątkami.
+ *
+ * Czytelnicy pobierają wskaźnik na bieżącą migawkę i dalej pracują na niej bez synchronizacji.
+ * Samo pobranie wskaźnika (std::atomic_load) może zająć krótką blokadę wewnętrzną biblioteki
+ * standardowej, ale nigdy nie czeka na mutex zapisu - trwający update() nie wstrzymuje odczytów.
+ * Zapis tworzy kopię migawki (kontenery Qt są współdzielone niejawnie, więc kopiowane
+ * są tylko zmieniane fragmenty), modyfikuje ją i publikuje przez atomową podmianę wskaźnika.
+ */
+class DataRepository : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DataRepository(QObject *parent = nullptr);
+
+    /// @brief Zwraca bieżącą migawkę danych; metoda bezpieczna wątkowo, nie czeka na trwający zapis.
+    std::shared_ptr<const DataSnapshot> snapshot() const;
+
+    /// @brief Publikuje nową listę stacji.
+    void publishStations(const QList<Station> &stations);
+
+    /// @brief Publikuje listę sensorów danej stacji.
+    void publishSensors(int stationId, const QList<Sensor> &sensors);
+
+    /// @brief Publikuje serię pomiarową danego sensora.
+    void publishMeasurements(int sensorId, const QList<Measurement> &measurements);
+
+    /**
+     * @brief Tworzy nową wersję danych na podstawie bieżącej i publikuje ją.
+     * @param change Funkcja modyfikująca kopię migawki.
+     */
+    template<typename Change>
+    void update(Change change) {
+        QMutexLocker locker(&writeMutex);
+        auto next = std::make_shared<DataSnapshot>(*std::atomic_load(&current));
+        change(*next);
+        next->version++;
+        const quint64 version = next->version;
+        std::atomic_store(&current, std::shared_ptr<const DataSnapshot>(std::move(next)));
+        locker.unlock();
+        emit snapshotPublished(version);
+    }
+
+signals:
+    void snapshotPublished(quint64 version);
+
+private:
+    std::shared_ptr<const DataSnapshot> current;
+    QMutex writeMutex;
+};
@@ -0,0 +1,142 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTcpSocket>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+
+/**
+ * @brief Klient obciążeniowy dla lokalnego serwera zapytań (QueryServer).
+ *
+ * Każdy wątek utrzymuje jedno połączenie keep-alive i wysyła kolejne zapytania,
+ * mierząc czas odpowiedzi. Na końcu wypisywana jest przepustowość i percentyle opóźnień.
+ */
+class LoadWorker : public QThread {
+public:
+    LoadWorker(const QString &host, quint16 port, const QByteArray &path, int requests)
+        : host(host), port(port), path(path), requests(requests) {}
+
+    QList<qint64> latencies; ///< Czasy odpowiedzi w mikrosekundach.
+    int errors = 0;
+
+protected:
+    void run() override {
+        QTcpSocket socket;
+        socket.connectToHost(host, port);
+        if (!socket.waitForConnected(5000)) {
+            errors = requests;
+            return;
+        }
+
+        const QByteArray request = "GET " + path + " HTTP/1.1\r\nHost: " + host.toUtf8() +
+                                   "\r\nConnection: keep-alive\r\n\r\n";
+        QByteArray buffer;
+        QElapsedTimer timer;
+        latencies.reserve(requests);
+
+        for (int i = 0; i < requests; ++i) {
+            timer.start();
+            socket.write(request);
+            if (!readResponse(socket, buffer)) {
+                errors += requests - i;
+                return;
+            }
+            latencies.append(timer.nsecsElapsed() / 1000);
+        }
+    }
+
+private:
+    static bool readResponse(QTcpSocket &socket, QByteArray &buffer) {
+        qsizetype headerEnd;
+        while ((headerEnd = buffer.indexOf("\r\n\r\n")) < 0) {
+            if (!socket.waitForReadyRead(5000)) {
+                return false;
+            }
+            buffer += socket.readAll();
+        }
+
+        qsizetype contentLength = 0;
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        if (!lines.first().startsWith("HTTP/1.1 200")) {
+            return false;
+        }
+        for (const auto &line : lines) {
+            if (line.toLower().startsWith("content-length:")) {
+                contentLength = line.mid(15).trimmed().toLongLong();
+            }
+        }
+
+        const qsizetype total = headerEnd + 4 + contentLength;
+        while (buffer.size() < total) {
+            if (!socket.waitForReadyRead(5000)) {
+                return false;
+            }
+            buffer += socket.readAll();
+        }
+        buffer.remove(0, total);
+        return true;
+    }
+
+    QString host;
+    quint16 port;
+    QByteArray path;
+    int requests;
+};
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Adres serwera.", "host", "127.0.0.1");
+    QCommandLineOption portOption("port", "Port serwera.", "port", "8080");
+    QCommandLineOption pathOption("path", "Ścieżka zapytania.", "path", "/stations");
+    QCommandLineOption clientsOption("clients", "Liczba równoległych połączeń.", "n", "16");
+    QCommandLineOption requestsOption("requests", "Liczba zapytań na połączenie.", "n", "1000");
+    parser.addOptions({ hostOption, portOption, pathOption, clientsOption, requestsOption });
+    parser.process(app);
+
+    const int clients = qMax(1, parser.value(clientsOption).toInt());
+    const int requests = qMax(1, parser.value(requestsOption).toInt());
+
+    QList<LoadWorker*> workers;
+    for (int i = 0; i < clients; ++i) {
+        workers.append(new LoadWorker(parser.value(hostOption), parser.value(portOption).toUShort(),
+                                      parser.value(pathOption).toUtf8(), requests));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (auto *w : workers) {
+        w->start();
+    }
+    for (auto *w : workers) {
+        w->wait();
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    QList<qint64> latencies;
+    int errors = 0;
+    for (auto *w : workers) {
+        latencies += w->latencies;
+        errors += w->errors;
+        delete w;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&latencies](double p) -> qint64 {
+        if (latencies.isEmpty()) {
+            return 0;
+        }
+        qsizetype i = qMin(latencies.size() - 1, qsizetype(p * latencies.size()));
+        return latencies[i];
+    };
+
+    QTextStream out(stdout);
+    out << "Zapytania: " << latencies.size() << " (błędy: " << errors << ")\n";
+    out << "Czas: " << seconds << " s\n";
+    out << "Przepustowość: " << qRound64(latencies.size() / seconds) << " zapytań/s\n";
+    out << "Opóźnienie p50: " << percentile(0.50) << " us, p99: " << percentile(0.99) << " us\n";
+    return errors > 0 ? 1 : 0;
+}
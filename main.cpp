@@ -1,9 +1,43 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
 #include "MainWindow.h"
 
 int main(int argc, char *argv[]) {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption serveOption("serve", "Uruchamia lokalny serwer zapytań HTTP/JSON na podanym porcie.", "port");
+    parser.addOption(serveOption);
+    QCommandLineOption backfillOption("backfill",
+        "Pobiera dane archiwalne z podanego adresu (%1 - id sensora, %2/%3 - początek/koniec porcji).", "url");
+    QCommandLineOption stationsOption("backfill-stations", "Id stacji do pobrania archiwum, rozdzielone przecinkami.", "ids");
+    QCommandLineOption fromOption("backfill-from", "Początek zakresu archiwum (yyyy-MM-dd).", "date");
+    QCommandLineOption toOption("backfill-to", "Koniec zakresu archiwum (yyyy-MM-dd, bez tego dnia).", "date");
+    parser.addOption(backfillOption);
+    parser.addOption(stationsOption);
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.process(a);
+
     MainWindow w;
+    if (parser.isSet(serveOption)) {
+        w.startQueryServer(parser.value(serveOption).toUShort());
+    }
+    if (parser.isSet(backfillOption)) {
+        QList<int> stationIds;
+        for (const QString &id : parser.value(stationsOption).split(',', Qt::SkipEmptyParts)) {
+            stationIds.append(id.trimmed().toInt());
+        }
+        QDateTime from = QDate::fromString(parser.value(fromOption), Qt::ISODate).startOfDay();
+        QDateTime to = QDate::fromString(parser.value(toOption), Qt::ISODate).startOfDay();
+        if (stationIds.isEmpty() || !from.isValid() || !to.isValid() || from >= to) {
+            qWarning("--backfill wymaga --backfill-stations, --backfill-from i --backfill-to (from < to).");
+            return 1;
+        }
+        w.startBackfill(parser.value(backfillOption), stationIds, from, to);
+    }
     w.show();
     return a.exec();
 }
@@ -2,11 +2,15 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
+#include <QStatusBar>
+#include <QThread>
 #include <cmath>
+#include <limits>
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include "StreamingExporter.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QWidget *central = new QWidget(this);
@@ -23,6 +27,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 
     findStationsButton = new QPushButton("Znajdź stacje w promieniu", this);
     saveDataButton = new QPushButton("Zapisz dane do JSON", this);
+    exportCsvButton = new QPushButton("Eksportuj do CSV", this);
 
     stationListWidget = new QListWidget(this);
     sensorListWidget = new QListWidget(this);
@@ -60,6 +65,18 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     chartView->setMinimumHeight(300);
 
     aqManager = new AirQualityManager(this);
+    repository = new DataRepository(this);
+    seriesCache.setMaxAge(30 * 60); // GIOŚ aktualizuje dane co godzinę
+    // Pamięć podręczna decyduje, które przeglądane serie zostają w repozytorium
+    seriesCache.setEvictionHandler([this](int sensorId) {
+        repository->update([sensorId](DataSnapshot &data) {
+            data.seriesBySensor.remove(sensorId);
+        });
+    });
+    queryServer = nullptr;
+    backfill = nullptr;
+    currentStationId = -1;
+    currentSensorId = -1;
 
     auto *layout = new QVBoxLayout(central);
     layout->addWidget(searchLineEdit);
@@ -69,6 +86,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     radiusLayout->addWidget(radiusLineEdit);
     radiusLayout->addWidget(findStationsButton);
     radiusLayout->addWidget(saveDataButton);
+    radiusLayout->addWidget(exportCsvButton);
     layout->addLayout(radiusLayout);
 
     layout->addWidget(stationListWidget);
@@ -83,6 +101,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     connect(sensorListWidget, &QListWidget::itemClicked, this, &MainWindow::onSensorClicked);
     connect(findStationsButton, &QPushButton::clicked, this, &MainWindow::onFindStationsInRadiusClicked);
     connect(saveDataButton, &QPushButton::clicked, this, &MainWindow::onSaveDataClicked);
+    connect(exportCsvButton, &QPushButton::clicked, this, &MainWindow::onExportCsvClicked);
     connect(aqManager, &AirQualityManager::stationsFetched, this, &MainWindow::onStationsFetched);
     connect(aqManager, &AirQualityManager::sensorsFetched, this, &MainWindow::onSensorsFetched);
     connect(aqManager, &AirQualityManager::measurementsFetched, this, &MainWindow::onMeasurementsFetched);
@@ -94,43 +113,91 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 }
 
 void MainWindow::onStationsFetched(const QList<Station> &stationsList) {
-    stations = stationsList;
+    repository->publishStations(stationsList);
     onSearchTextChanged(searchLineEdit->text());
-    stationListWidget->clear();
-    for (const auto &s : stations) {
-        stationListWidget->addItem(s.name);
-    }
-    saveStationsToJson(stations);
+    saveStationsToJson(stationsList);
 }
 
 void MainWindow::onStationClicked(QListWidgetItem *item) {
+    // Lista pokazuje stacje z filteredStations (wyszukiwanie lub promień)
     int index = stationListWidget->row(item);
-    if (index >= 0 && index < stations.size()) {
-        aqManager->fetchSensors(stations[index].id);
+    if (index >= 0 && index < filteredStations.size()) {
+        currentStationId = filteredStations[index].id;
+        aqManager->fetchSensors(currentStationId);
     }
 }
 
-void MainWindow::onSensorsFetched(const QList<Sensor> &sensorList) {
-    sensors = sensorList;
+void MainWindow::onSensorsFetched(int stationId, const QList<Sensor> &sensorList) {
+    repository->publishSensors(stationId, sensorList);
+    // Pobieranie archiwum startuje, gdy znane są sensory wszystkich wskazanych stacji
+    if (backfillStations.remove(stationId) && backfillStations.isEmpty()) {
+        std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+        QList<int> sensorIds;
+        for (int id : backfillStationIds) {
+            for (const auto &sensor : data->sensorsByStation.value(id)) {
+                sensorIds.append(sensor.id);
+            }
+        }
+        backfill->start(sensorIds, backfillFrom, backfillTo);
+    }
+    // Odpowiedź dla wcześniej klikniętej stacji nie zmienia widoku
+    if (stationId != currentStationId) {
+        return;
+    }
+    showSensors(sensorList);
+    saveSensorsToJson(stationId, sensorList);
+}
+
+void MainWindow::showSensors(const QList<Sensor> &sensorList) {
     sensorListWidget->clear();
     measurementListWidget->clear();
     analysisTextEdit->clear();
     series->clear();
-    for (const auto &s : sensors) {
+    for (const auto &s : sensorList) {
         sensorListWidget->addItem(s.paramName);
     }
-    saveSensorsToJson(sensors);
 }
 
 void MainWindow::onSensorClicked(QListWidgetItem *item) {
+    const QList<Sensor> sensors = currentSensors();
     int index = sensorListWidget->row(item);
     if (index >= 0 && index < sensors.size()) {
-        aqManager->fetchSensorData(sensors[index].id);
+        // Wyświetlana seria nie może zostać usunięta z pamięci podręcznej
+        seriesCache.unpin(currentSensorId);
+        currentSensorId = sensors[index].id;
+        seriesCache.pin(currentSensorId);
+        QList<Measurement> cached;
+        if (seriesCache.lookup(currentSensorId, &cached)) {
+            showMeasurements(cached);
+            SeriesCacheStats stats = seriesCache.stats();
+            statusBar()->showMessage(QString("Dane z pamięci podręcznej (trafienia: %1, chybienia: %2, %3 KB)")
+                                         .arg(stats.hits).arg(stats.misses).arg(stats.bytes / 1024), 3000);
+            return;
+        }
+        aqManager->fetchSensorData(currentSensorId);
     }
 }
 
-void MainWindow::onMeasurementsFetched(const QList<Measurement> &measurementsList) {
-    measurements = measurementsList;
+void MainWindow::onMeasurementsFetched(int sensorId, const QList<Measurement> &measurementsList) {
+    repository->publishMeasurements(sensorId, measurementsList);
+    seriesCache.insert(sensorId, measurementsList);
+    // Odpowiedź dla wcześniej klikniętego sensora trafia tylko do repozytorium i pamięci podręcznej
+    if (sensorId != currentSensorId) {
+        return;
+    }
+    showMeasurements(measurementsList);
+    saveMeasurementsToJson(sensorId, measurementsList);
+}
+
+QList<Sensor> MainWindow::currentSensors() const {
+    return repository->snapshot()->sensorsByStation.value(currentStationId);
+}
+
+QList<Measurement> MainWindow::currentMeasurements() const {
+    return repository->snapshot()->seriesBySensor.value(currentSensorId);
+}
+
+void MainWindow::showMeasurements(const QList<Measurement> &measurements) {
     measurementListWidget->clear();
     analysisTextEdit->clear();
     series->clear();
@@ -147,14 +214,14 @@ void MainWindow::onMeasurementsFetched(const QList<Measurement> &measurementsLis
         updateChart(measurements);
         analyzeMeasurements(measurements);
     }
-    saveMeasurementsToJson(measurements);
 }
 
 void MainWindow::onSearchTextChanged(const QString &text) {
     stationListWidget->clear();
     filteredStations.clear();
 
-    for (const auto &station : stations) {
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    for (const auto &station : data->stations) {
         if (station.name.contains(text, Qt::CaseInsensitive)) {
             stationListWidget->addItem(station.name);
             filteredStations.append(station);
@@ -188,7 +255,8 @@ void MainWindow::onCoordinatesFetched(double latitude, double longitude) {
     stationListWidget->clear();
     filteredStations.clear();
 
-    for (const auto &station : stations) {
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    for (const auto &station : data->stations) {
         double distance = calculateDistance(latitude, longitude, station.latitude, station.longitude);
         if (distance <= radius) {
             stationListWidget->addItem(station.name);
@@ -202,12 +270,40 @@ void MainWindow::onCoordinatesFetched(double latitude, double longitude) {
 }
 
 void MainWindow::onSaveDataClicked() {
-    saveStationsToJson(stations);
-    saveSensorsToJson(sensors);
-    saveMeasurementsToJson(measurements);
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    saveStationsToJson(data->stations);
+    saveSensorsToJson(currentStationId, data->sensorsByStation.value(currentStationId));
+    if (!saveMeasurementsToJson(currentSensorId, data->seriesBySensor.value(currentSensorId))) {
+        return;
+    }
     QMessageBox::information(this, "Sukces", "Dane zostały zapisane do plików JSON.");
 }
 
+void MainWindow::onExportCsvClicked() {
+    // Eksport wielu lat danych trwa długo - wykonywany jest w osobnym wątku na niezmiennej migawce
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    auto stats = std::make_shared<ExportStats>();
+    QThread *worker = QThread::create([data, stats]() {
+        *stats = StreamingExporter::exportToFile("measurements.csv", StreamingExporter::Format::Csv,
+                                                 data->sensorsByStation, data->seriesBySensor);
+    });
+    exportCsvButton->setEnabled(false);
+    statusBar()->showMessage("Eksport do CSV w toku...");
+    connect(worker, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &QThread::finished, this, [this, stats]() {
+        exportCsvButton->setEnabled(true);
+        statusBar()->clearMessage();
+        if (!stats->ok) {
+            QMessageBox::warning(this, "Błąd", "Nie udało się zapisać pomiarów do pliku CSV.");
+            return;
+        }
+        QMessageBox::information(this, "Sukces",
+                                 QString("Wyeksportowano %1 wierszy (%2 wierszy/s).")
+                                     .arg(stats->rows).arg(qRound64(stats->rowsPerSecond)));
+    });
+    worker->start();
+}
+
 void MainWindow::onErrorOccurred(const QString &error) {
     QMessageBox::warning(this, "Błąd", error);
 
@@ -225,36 +321,27 @@ void MainWindow::onErrorOccurred(const QString &error) {
         if (reply == QMessageBox::Yes) {
             QList<Station> historicalStations = loadStationsFromJson();
             if (!historicalStations.isEmpty()) {
-                stations = historicalStations;
-                stationListWidget->clear();
-                for (const auto &s : stations) {
-                    stationListWidget->addItem(s.name);
-                }
+                repository->publishStations(historicalStations);
+                onSearchTextChanged(searchLineEdit->text());
             }
 
-            QList<Sensor> historicalSensors = loadSensorsFromJson();
+            int stationId = -1;
+            QList<Sensor> historicalSensors = loadSensorsFromJson(&stationId);
             if (!historicalSensors.isEmpty()) {
-                sensors = historicalSensors;
-                sensorListWidget->clear();
-                for (const auto &s : sensors) {
-                    sensorListWidget->addItem(s.paramName);
-                }
+                currentStationId = stationId;
+                repository->publishSensors(stationId, historicalSensors);
+                showSensors(historicalSensors);
             }
 
-            QList<Measurement> historicalMeasurements = loadMeasurementsFromJson();
+            int sensorId = -1;
+            QList<Measurement> historicalMeasurements = loadMeasurementsFromJson(&sensorId);
             if (!historicalMeasurements.isEmpty()) {
-                measurements = historicalMeasurements;
-                measurementListWidget->clear();
-                analysisTextEdit->clear();
-                series->clear();
-                for (const auto &m : measurements) {
-                    QString valueStr = (m.value >= 0) ? QString::number(m.value) : "brak";
-                    measurementListWidget->addItem(
-                        QString("%1: %2 (%3)").arg(m.paramName).arg(valueStr).arg(m.dateTime.toString())
-                        );
-                }
-                updateChart(measurements);
-                analyzeMeasurements(measurements);
+                seriesCache.unpin(currentSensorId);
+                currentSensorId = sensorId;
+                seriesCache.pin(currentSensorId);
+                repository->publishMeasurements(sensorId, historicalMeasurements);
+                seriesCache.insert(sensorId, historicalMeasurements);
+                showMeasurements(historicalMeasurements);
             }
 
             if (historicalStations.isEmpty() && historicalSensors.isEmpty() && historicalMeasurements.isEmpty()) {
@@ -268,7 +355,47 @@ void MainWindow::onErrorOccurred(const QString &error) {
     }
 }
 
+bool MainWindow::startQueryServer(quint16 port) {
+    if (!queryServer) {
+        queryServer = new QueryServer(repository, this);
+    }
+    if (!queryServer->start(port)) {
+        QMessageBox::warning(this, "Błąd", "Nie udało się uruchomić serwera zapytań: " + queryServer->errorString());
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::startBackfill(const QString &endpoint, const QList<int> &stationIds,
+                               const QDateTime &from, const QDateTime &to) {
+    if (!backfill) {
+        backfill = new BackfillPipeline(repository, this);
+        connect(backfill, &BackfillPipeline::progress, this, [this](qint64 points, double pointsPerSecond) {
+            statusBar()->showMessage(QString("Archiwum: %1 pomiarów (%2/s)").arg(points).arg(qRound64(pointsPerSecond)));
+        });
+        connect(backfill, &BackfillPipeline::finished, this, [this](const BackfillStats &stats) {
+            statusBar()->showMessage(QString("Archiwum pobrane: %1 pomiarów, %2 zapytań, błędne sensory: %3")
+                                         .arg(stats.points).arg(stats.requests).arg(stats.failedSensors));
+        });
+        connect(backfill, &BackfillPipeline::errorOccurred, this, [this](const QString &error) {
+            statusBar()->showMessage(error, 5000);
+        });
+    }
+    if (backfill->isRunning() || !backfillStations.isEmpty() || stationIds.isEmpty()) {
+        return;
+    }
+    backfill->setEndpoint(endpoint);
+    backfillStationIds = stationIds;
+    backfillStations = QSet<int>(stationIds.cbegin(), stationIds.cend());
+    backfillFrom = from;
+    backfillTo = to;
+    for (int stationId : stationIds) {
+        aqManager->fetchSensors(stationId);
+    }
+}
+
 void MainWindow::onPeriodChanged(const QString &period) {
+    const QList<Measurement> measurements = currentMeasurements();
     if (!measurements.isEmpty()) {
         updateChart(measurements);
     }
@@ -300,10 +427,11 @@ void MainWindow::analyzeMeasurements(const QList<Measurement> &measurements) {
         return;
     }
 
-    double minValue = measurements.first().value;
-    double maxValue = measurements.first().value;
-    QDateTime minDateTime = measurements.first().dateTime;
-    QDateTime maxDateTime = measurements.first().dateTime;
+    // Brakujące pomiary (NaN lub wartość ujemna) nie mogą być wartością początkową
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+    QDateTime minDateTime;
+    QDateTime maxDateTime;
     double sum = 0.0;
     int validCount = 0;
 
@@ -322,7 +450,12 @@ void MainWindow::analyzeMeasurements(const QList<Measurement> &measurements) {
         }
     }
 
-    double average = (validCount > 0) ? sum / validCount : 0.0;
+    if (validCount == 0) {
+        analysisTextEdit->setText("Brak danych do analizy.");
+        return;
+    }
+
+    double average = sum / validCount;
 
     double trend = 0.0;
     if (validCount > 1) {
@@ -380,11 +513,12 @@ void MainWindow::saveStationsToJson(const QList<Station> &stations) {
     }
 }
 
-void MainWindow::saveSensorsToJson(const QList<Sensor> &sensors) {
+void MainWindow::saveSensorsToJson(int stationId, const QList<Sensor> &sensors) {
     QJsonArray sensorsArray;
     for (const auto &s : sensors) {
         QJsonObject sensorObj;
         sensorObj["id"] = s.id;
+        sensorObj["stationId"] = stationId;
         sensorObj["paramName"] = s.paramName;
         sensorsArray.append(sensorObj);
     }
@@ -399,24 +533,33 @@ void MainWindow::saveSensorsToJson(const QList<Sensor> &sensors) {
     }
 }
 
-void MainWindow::saveMeasurementsToJson(const QList<Measurement> &measurements) {
-    QJsonArray measurementsArray;
-    for (const auto &m : measurements) {
-        QJsonObject measurementObj;
-        measurementObj["paramName"] = m.paramName;
-        measurementObj["value"] = m.value;
-        measurementObj["dateTime"] = m.dateTime.toString(Qt::ISODate);
-        measurementsArray.append(measurementObj);
-    }
-
-    QJsonDocument doc(measurementsArray);
+bool MainWindow::saveMeasurementsToJson(int sensorId, const QList<Measurement> &measurements) {
     QFile file("measurements.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(doc.toJson());
+    bool ok = file.open(QIODevice::WriteOnly);
+    if (ok) {
+        // Zapis strumieniowy - bez budowania całego dokumentu JSON w pamięci
+        BufferedWriter writer(&file);
+        writer.write('[');
+        for (qsizetype i = 0; i < measurements.size(); ++i) {
+            const Measurement &m = measurements[i];
+            QJsonObject measurementObj;
+            measurementObj["sensorId"] = sensorId;
+            measurementObj["paramName"] = m.paramName;
+            measurementObj["value"] = (m.value >= 0) ? QJsonValue(m.value) : QJsonValue(QJsonValue::Null);
+            measurementObj["dateTime"] = m.dateTime.toString(Qt::ISODate);
+            if (i > 0) {
+                writer.write(',');
+            }
+            writer.write(QJsonDocument(measurementObj).toJson(QJsonDocument::Compact));
+        }
+        writer.write(']');
+        ok = writer.flush();
         file.close();
-    } else {
+    }
+    if (!ok) {
         QMessageBox::warning(this, "Błąd", "Nie udało się zapisać pomiarów do pliku JSON.");
     }
+    return ok;
 }
 
 QList<Station> MainWindow::loadStationsFromJson() {
@@ -439,7 +582,7 @@ QList<Station> MainWindow::loadStationsFromJson() {
     return stations;
 }
 
-QList<Sensor> MainWindow::loadSensorsFromJson() {
+QList<Sensor> MainWindow::loadSensorsFromJson(int *stationId) {
     QList<Sensor> sensors;
     QFile file("sensors.json");
     if (file.open(QIODevice::ReadOnly)) {
@@ -450,6 +593,8 @@ QList<Sensor> MainWindow::loadSensorsFromJson() {
             Sensor s;
             s.id = obj["id"].toInt();
             s.paramName = obj["paramName"].toString();
+            // Pliki zapisane przez starsze wersje nie zawierają id stacji
+            *stationId = obj["stationId"].toInt(-1);
             sensors.append(s);
         }
         file.close();
@@ -457,7 +602,7 @@ QList<Sensor> MainWindow::loadSensorsFromJson() {
     return sensors;
 }
 
-QList<Measurement> MainWindow::loadMeasurementsFromJson() {
+QList<Measurement> MainWindow::loadMeasurementsFromJson(int *sensorId) {
     QList<Measurement> measurements;
     QFile file("measurements.json");
     if (file.open(QIODevice::ReadOnly)) {
@@ -466,8 +611,9 @@ QList<Measurement> MainWindow::loadMeasurementsFromJson() {
         for (const auto &v : arr) {
             QJsonObject obj = v.toObject();
             Measurement m;
+            *sensorId = obj["sensorId"].toInt(-1);
             m.paramName = obj["paramName"].toString();
-            m.value = obj["value"].toDouble();
+            m.value = obj["value"].toDouble(std::numeric_limits<double>::quiet_NaN());
             m.dateTime = QDateTime::fromString(obj["dateTime"].toString(), Qt::ISODate);
             measurements.append(m);
         }
@@ -4,6 +4,11 @@
 #include <QListWidget>
 #include <QPushButton>
 #include "AirQualityManager.h"
+#include "DataRepository.h"
+#include "QueryServer.h"
+#include "SeriesCache.h"
+#include "BackfillPipeline.h"
+#include <QSet>
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QtCharts/QChartView>
@@ -19,34 +24,48 @@ public:
     MainWindow(QWidget *parent = nullptr);
     double calculateDistance(double lat1, double lon1, double lat2, double lon2);
     void analyzeMeasurements(const QList<Measurement> &measurements);
+    bool startQueryServer(quint16 port);
+
+    /**
+     * @brief Pobiera dane archiwalne wszystkich sensorów podanych stacji.
+     * @param endpoint Szablon adresu archiwum (zob. BackfillPipeline::setEndpoint).
+     */
+    void startBackfill(const QString &endpoint, const QList<int> &stationIds,
+                       const QDateTime &from, const QDateTime &to);
 
 private slots:
     void onStationsFetched(const QList<Station> &stations);
     void onStationClicked(QListWidgetItem *item);
-    void onSensorsFetched(const QList<Sensor> &sensors);
+    void onSensorsFetched(int stationId, const QList<Sensor> &sensors);
     void onSensorClicked(QListWidgetItem *item);
-    void onMeasurementsFetched(const QList<Measurement> &measurements);
+    void onMeasurementsFetched(int sensorId, const QList<Measurement> &measurements);
     void onSearchTextChanged(const QString &text);
     void onFindStationsInRadiusClicked();
     void onCoordinatesFetched(double latitude, double longitude); // Nowy slot
     void onSaveDataClicked();
+    void onExportCsvClicked();
     void onErrorOccurred(const QString &error);
     void onPeriodChanged(const QString &period);
 
 private:
     void saveStationsToJson(const QList<Station> &stations);
-    void saveSensorsToJson(const QList<Sensor> &sensors);
-    void saveMeasurementsToJson(const QList<Measurement> &measurements);
+    void saveSensorsToJson(int stationId, const QList<Sensor> &sensors);
+    bool saveMeasurementsToJson(int sensorId, const QList<Measurement> &measurements);
     QList<Station> loadStationsFromJson();
-    QList<Sensor> loadSensorsFromJson();
-    QList<Measurement> loadMeasurementsFromJson();
+    QList<Sensor> loadSensorsFromJson(int *stationId);
+    QList<Measurement> loadMeasurementsFromJson(int *sensorId);
     void updateChart(const QList<Measurement> &measurements);
+    void showSensors(const QList<Sensor> &sensors);
+    void showMeasurements(const QList<Measurement> &measurements);
+    QList<Sensor> currentSensors() const;
+    QList<Measurement> currentMeasurements() const;
 
     QLineEdit *searchLineEdit;
     QLineEdit *addressLineEdit;
     QLineEdit *radiusLineEdit;
     QPushButton *findStationsButton;
     QPushButton *saveDataButton;
+    QPushButton *exportCsvButton;
     QListWidget *stationListWidget;
     QListWidget *sensorListWidget;
     QListWidget *measurementListWidget;
@@ -55,9 +74,17 @@ private:
     QChartView *chartView;
     QLineSeries *series;
     AirQualityManager *aqManager;
+    DataRepository *repository;
+    QueryServer *queryServer;
+    BackfillPipeline *backfill;
+    QSet<int> backfillStations;    ///< Stacje, na których sensory czeka pobieranie archiwum.
+    QList<int> backfillStationIds;
+    QDateTime backfillFrom;
+    QDateTime backfillTo;
+    SeriesCache seriesCache;
 
-    QList<Station> stations;
+    // Dane stacji, sensorów i pomiarów są przechowywane w repozytorium; tu tylko stan widoku
     QList<Station> filteredStations;
-    QList<Sensor> sensors;
-    QList<Measurement> measurements;
+    int currentStationId;
+    int currentSensorId;
 };
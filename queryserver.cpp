@@ -0,0 +1,302 @@
+#include "QueryServer.h"
+#include <QTcpSocket>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QUrl>
+#include <limits>
+
+namespace {
+
+const qsizetype kMaxHeaderSize = 16 * 1024;
+const int kMaxCachedResponses = 4096;
+
+QByteArray statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    default: return "Internal Server Error";
+    }
+}
+
+QueryResponse errorResponse(int status, const QString &message) {
+    QJsonObject obj;
+    obj["error"] = message;
+    return { status, QJsonDocument(obj).toJson(QJsonDocument::Compact) };
+}
+
+bool inRange(const QDateTime &dateTime, const QDateTime &from, const QDateTime &to) {
+    return (!from.isValid() || dateTime >= from) && (!to.isValid() || dateTime <= to);
+}
+
+/**
+ * @brief Pojedyncze połączenie HTTP obsługiwane w wątku roboczym (keep-alive, pipelining).
+ */
+class HttpConnection : public QObject {
+public:
+    HttpConnection(qintptr descriptor, QueryServer *server)
+        : descriptor(descriptor), server(server) {}
+
+    void start() {
+        socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(descriptor)) {
+            deleteLater();
+            return;
+        }
+        connect(socket, &QTcpSocket::readyRead, this, [this]() { processBuffer(); });
+        connect(socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+    }
+
+private:
+    void processBuffer() {
+        buffer += socket->readAll();
+        while (socket->state() == QAbstractSocket::ConnectedState) {
+            qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                if (buffer.size() > kMaxHeaderSize) {
+                    writeResponse(errorResponse(400, "Zbyt długi nagłówek zapytania."), false);
+                }
+                return;
+            }
+
+            const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+            const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+            bool keepAlive = requestLine.value(2) == "HTTP/1.1";
+            qint64 contentLength = 0;
+            bool lengthValid = true;
+            for (qsizetype i = 1; i < lines.size(); ++i) {
+                qsizetype colon = lines[i].indexOf(':');
+                if (colon < 0) {
+                    continue;
+                }
+                QByteArray name = lines[i].left(colon).trimmed().toLower();
+                QByteArray value = lines[i].mid(colon + 1).trimmed().toLower();
+                if (name == "content-length") {
+                    contentLength = value.toLongLong(&lengthValid);
+                    // Obsługiwany jest tylko GET, więc treść zapytania nie może być większa od nagłówka
+                    lengthValid = lengthValid && contentLength >= 0 && contentLength <= kMaxHeaderSize;
+                    if (!lengthValid) {
+                        break;
+                    }
+                } else if (name == "connection") {
+                    keepAlive = (value == "keep-alive") || (keepAlive && value != "close");
+                }
+            }
+
+            if (!lengthValid) {
+                buffer.clear();
+                writeResponse(errorResponse(400, "Niepoprawny nagłówek Content-Length."), false);
+                return;
+            }
+
+            const qsizetype total = headerEnd + 4 + qsizetype(contentLength);
+            if (buffer.size() < total) {
+                return;
+            }
+            buffer.remove(0, total);
+
+            if (requestLine.size() != 3) {
+                writeResponse(errorResponse(400, "Niepoprawne zapytanie."), false);
+                return;
+            }
+            writeResponse(server->handleRequest(requestLine[0], requestLine[1]), keepAlive);
+        }
+    }
+
+    void writeResponse(const QueryResponse &response, bool keepAlive) {
+        QByteArray out;
+        out.reserve(response.body.size() + 160);
+        out += "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + statusText(response.status) + "\r\n";
+        out += "Content-Type: application/json; charset=utf-8\r\n";
+        out += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+        out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        out += response.body;
+        socket->write(out);
+        if (!keepAlive) {
+            socket->disconnectFromHost();
+        }
+    }
+
+    qintptr descriptor;
+    QueryServer *server;
+    QTcpSocket *socket = nullptr;
+    QByteArray buffer;
+};
+
+} // namespace
+
+QueryServer::QueryServer(DataRepository *repository, QObject *parent)
+    : QTcpServer(parent), repository(repository) {}
+
+QueryServer::~QueryServer() {
+    stop();
+}
+
+bool QueryServer::start(quint16 port, int workerCount) {
+    if (!listen(QHostAddress::LocalHost, port)) {
+        return false;
+    }
+    for (int i = 0; i < qMax(1, workerCount); ++i) {
+        QThread *worker = new QThread(this);
+        worker->start();
+        workers.append(worker);
+    }
+    return true;
+}
+
+void QueryServer::stop() {
+    close();
+    for (QThread *worker : workers) {
+        worker->quit();
+        worker->wait();
+        delete worker;
+    }
+    workers.clear();
+    nextWorker = 0;
+}
+
+void QueryServer::incomingConnection(qintptr socketDescriptor) {
+    // Bez wątków roboczych (listen() wywołane z pominięciem start()) połączenie jest zamykane
+    if (workers.isEmpty()) {
+        QTcpSocket socket;
+        if (socket.setSocketDescriptor(socketDescriptor)) {
+            socket.abort();
+        }
+        return;
+    }
+    QThread *worker = workers[nextWorker];
+    nextWorker = (nextWorker + 1) % workers.size();
+
+    auto *connection = new HttpConnection(socketDescriptor, this);
+    connection->moveToThread(worker);
+    connect(worker, &QThread::finished, connection, &QObject::deleteLater);
+    QMetaObject::invokeMethod(connection, [connection]() { connection->start(); }, Qt::QueuedConnection);
+}
+
+QueryResponse QueryServer::handleRequest(const QByteArray &method, const QByteArray &target) {
+    if (method != "GET") {
+        return errorResponse(405, "Obsługiwane są tylko zapytania GET.");
+    }
+
+    std::shared_ptr<const DataSnapshot> data = repository->snapshot();
+    {
+        QMutexLocker locker(&cacheMutex);
+        if (data->version > cacheVersion) {
+            responseCache.clear();
+            cacheVersion = data->version;
+        } else if (data->version == cacheVersion) {
+            auto it = responseCache.constFind(target);
+            if (it != responseCache.constEnd()) {
+                return it.value();
+            }
+        }
+    }
+
+    QUrl url = QUrl::fromEncoded(target);
+    QueryResponse response = buildResponse(*data, url.path(), QUrlQuery(url));
+
+    if (response.status == 200) {
+        QMutexLocker locker(&cacheMutex);
+        // Odpowiedź zbudowana na starszej migawce nie trafia do pamięci podręcznej
+        if (data->version == cacheVersion) {
+            if (responseCache.size() >= kMaxCachedResponses) {
+                responseCache.clear();
+            }
+            responseCache.insert(target, response);
+        }
+    }
+    return response;
+}
+
+QueryResponse QueryServer::buildResponse(const DataSnapshot &data, const QString &path, const QUrlQuery &query) {
+    const QStringList parts = path.split('/', Qt::SkipEmptyParts);
+    const QDateTime from = QDateTime::fromString(query.queryItemValue("from"), Qt::ISODate);
+    const QDateTime to = QDateTime::fromString(query.queryItemValue("to"), Qt::ISODate);
+
+    if (parts.size() == 1 && parts[0] == "stations") {
+        QJsonArray array;
+        for (const auto &s : data.stations) {
+            QJsonObject obj;
+            obj["id"] = s.id;
+            obj["name"] = s.name;
+            obj["latitude"] = s.latitude;
+            obj["longitude"] = s.longitude;
+            array.append(obj);
+        }
+        return { 200, QJsonDocument(array).toJson(QJsonDocument::Compact) };
+    }
+
+    bool ok = false;
+    int id = parts.value(1).toInt(&ok);
+    if (parts.size() != 3 || !ok) {
+        return errorResponse(404, "Nieznany zasób.");
+    }
+
+    if (parts[0] == "stations" && parts[2] == "sensors") {
+        auto it = data.sensorsByStation.constFind(id);
+        if (it == data.sensorsByStation.constEnd()) {
+            return errorResponse(404, "Brak sensorów dla podanej stacji.");
+        }
+        QJsonArray array;
+        for (const auto &s : it.value()) {
+            QJsonObject obj;
+            obj["id"] = s.id;
+            obj["paramName"] = s.paramName;
+            array.append(obj);
+        }
+        return { 200, QJsonDocument(array).toJson(QJsonDocument::Compact) };
+    }
+
+    if (parts[0] != "sensors") {
+        return errorResponse(404, "Nieznany zasób.");
+    }
+    auto it = data.seriesBySensor.constFind(id);
+    if (it == data.seriesBySensor.constEnd()) {
+        return errorResponse(404, "Brak danych pomiarowych dla podanego sensora.");
+    }
+    const QList<Measurement> &measurements = it.value();
+
+    if (parts[2] == "series") {
+        // Format zgodny z /pjp-api/rest/data/getData - brakujące wartości jako null
+        QJsonArray values;
+        for (const auto &m : measurements) {
+            if (!inRange(m.dateTime, from, to)) {
+                continue;
+            }
+            QJsonObject obj;
+            obj["date"] = m.dateTime.toString(Qt::ISODate);
+            obj["value"] = (m.value >= 0) ? QJsonValue(m.value) : QJsonValue(QJsonValue::Null);
+            values.append(obj);
+        }
+        QJsonObject obj;
+        obj["key"] = measurements.isEmpty() ? QString() : measurements.first().paramName;
+        obj["values"] = values;
+        return { 200, QJsonDocument(obj).toJson(QJsonDocument::Compact) };
+    }
+
+    if (parts[2] == "aggregate") {
+        double minValue = std::numeric_limits<double>::max();
+        double maxValue = std::numeric_limits<double>::lowest();
+        double sum = 0.0;
+        int count = 0;
+        for (const auto &m : measurements) {
+            if (m.value >= 0 && inRange(m.dateTime, from, to)) {
+                minValue = qMin(minValue, m.value);
+                maxValue = qMax(maxValue, m.value);
+                sum += m.value;
+                count++;
+            }
+        }
+        QJsonObject obj;
+        obj["sensorId"] = id;
+        obj["count"] = count;
+        obj["min"] = (count > 0) ? QJsonValue(minValue) : QJsonValue(QJsonValue::Null);
+        obj["max"] = (count > 0) ? QJsonValue(maxValue) : QJsonValue(QJsonValue::Null);
+        obj["avg"] = (count > 0) ? QJsonValue(sum / count) : QJsonValue(QJsonValue::Null);
+        return { 200, QJsonDocument(obj).toJson(QJsonDocument::Compact) };
+    }
+
+    return errorResponse(404, "Nieznany zasób.");
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <QTcpServer>
+#include <QThread>
+#include <QMutex>
+#include <QUrlQuery>
+#include <QHash>
+#include "DataRepository.h"
+
+/**
+ * @struct QueryResponse
+ * @brief Gotowa (zserializowana) odpowiedź serwera zapytań.
+ */
+struct QueryResponse {
+    int status = 200;
+    QByteArray body;
+};
+
+/**
+ * @class QueryServer
+ * @brief Lokalny serwer HTTP/JSON udostępniający pobrane dane innym usługom.
+ *
+ * Obsługiwane zapytania (GET):
+ * - /stations
+ * - /stations/{id}/sensors
+ * - /sensors/{id}/series?from=...&to=... (format zgodny z api.gios.gov.pl)
+ * - /sensors/{id}/aggregate?from=...&to=...
+ *
+ * Dane są czytane z migawek DataRepository. Połączenia są obsługiwane przez pulę
+ * wątków roboczych, a odpowiedzi trafiają do pamięci podręcznej do czasu
+ * opublikowania nowej wersji danych.
+ */
+class QueryServer : public QTcpServer {
+    Q_OBJECT
+
+public:
+    explicit QueryServer(DataRepository *repository, QObject *parent = nullptr);
+    ~QueryServer() override;
+
+    /// @brief Uruchamia serwer na podanym porcie (tylko localhost).
+    bool start(quint16 port, int workerCount = QThread::idealThreadCount());
+
+    /// @brief Zatrzymuje serwer i wątki robocze.
+    void stop();
+
+    /// @brief Obsługuje zapytanie; metoda bezpieczna wątkowo.
+    QueryResponse handleRequest(const QByteArray &method, const QByteArray &target);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    static QueryResponse buildResponse(const DataSnapshot &data, const QString &path, const QUrlQuery &query);
+
+    DataRepository *repository;
+
+    QMutex cacheMutex;
+    QHash<QByteArray, QueryResponse> responseCache;
+    quint64 cacheVersion = 0;
+
+    QList<QThread*> workers;
+    int nextWorker = 0;
+};
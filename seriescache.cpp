@@ -0,0 +1,101 @@
+#include "SeriesCache.h"
+
+SeriesCache::SeriesCache(qint64 byteBudget) : budget(byteBudget) {}
+
+void SeriesCache::setByteBudget(qint64 bytes) {
+    budget = bytes;
+    evict();
+}
+
+bool SeriesCache::lookup(int sensorId, QList<Measurement> *series) {
+    auto it = entries.find(sensorId);
+    if (it == entries.end()) {
+        misses++;
+        return false;
+    }
+    if (maxAgeSecs > 0 && it->age.elapsed() > maxAgeSecs * 1000) {
+        remove(sensorId);
+        misses++;
+        if (onEvict) {
+            onEvict(sensorId);
+        }
+        return false;
+    }
+
+    lru.splice(lru.end(), lru, it->lruPosition);
+    *series = it->series;
+    hits++;
+    return true;
+}
+
+void SeriesCache::insert(int sensorId, const QList<Measurement> &series) {
+    remove(sensorId);
+
+    Entry entry;
+    entry.series = series;
+    entry.bytes = estimateBytes(series);
+    entry.age.start();
+    entry.lruPosition = lru.insert(lru.end(), sensorId);
+    usedBytes += entry.bytes;
+    entries.insert(sensorId, entry);
+    evict();
+}
+
+void SeriesCache::remove(int sensorId) {
+    auto it = entries.find(sensorId);
+    if (it == entries.end()) {
+        return;
+    }
+    usedBytes -= it->bytes;
+    lru.erase(it->lruPosition);
+    entries.erase(it);
+}
+
+void SeriesCache::pin(int sensorId) {
+    pinned.insert(sensorId);
+}
+
+void SeriesCache::unpin(int sensorId) {
+    pinned.remove(sensorId);
+    evict();
+}
+
+SeriesCacheStats SeriesCache::stats() const {
+    SeriesCacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.evictions = evictions;
+    s.bytes = usedBytes;
+    s.entries = entries.size();
+    return s;
+}
+
+qint64 SeriesCache::estimateBytes(const QList<Measurement> &series) {
+    qint64 bytes = sizeof(Entry) + qint64(series.capacity()) * qint64(sizeof(Measurement));
+    // Pomiary jednej serii zwykle współdzielą ten sam QString z nazwą parametru
+    const QChar *previous = nullptr;
+    for (const auto &m : series) {
+        if (m.paramName.constData() != previous) {
+            bytes += qint64(m.paramName.capacity()) * qint64(sizeof(QChar));
+            previous = m.paramName.constData();
+        }
+    }
+    return bytes;
+}
+
+void SeriesCache::evict() {
+    // Od najdawniej używanych; przypięte serie są pomijane
+    auto it = lru.begin();
+    while (usedBytes > budget && it != lru.end()) {
+        int sensorId = *it;
+        ++it;
+        if (pinned.contains(sensorId)) {
+            continue;
+        }
+        remove(sensorId);
+        evictions++;
+        if (onEvict) {
+            onEvict(sensorId);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <list>
+#include <functional>
+#include "AirQualityManager.h"
+
+/**
+ * @struct SeriesCacheStats
+ * @brief Statystyki pamięci podręcznej serii pomiarowych.
+ */
+struct SeriesCacheStats {
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 evictions = 0;
+    qint64 bytes = 0;
+    int entries = 0;
+};
+
+/**
+ * @class SeriesCache
+ * @brief Pamięć podręczna serii pomiarowych (klucz: id sensora) z limitem bajtów i usuwaniem LRU.
+ *
+ * Przypięte sensory nie są usuwane przy przekroczeniu limitu. Seria jest współdzielona
+ * (niejawnie) z innymi właścicielami, np. DataRepository - aby limit rzeczywiście
+ * ograniczał pamięć, właściciel powinien usuwać serię w funkcji setEvictionHandler().
+ */
+class SeriesCache {
+public:
+    explicit SeriesCache(qint64 byteBudget = 64 * 1024 * 1024);
+
+    /// @brief Ustawia limit pamięci w bajtach (usuwa nadmiarowe wpisy).
+    void setByteBudget(qint64 bytes);
+    qint64 byteBudget() const { return budget; }
+
+    /// @brief Ustawia funkcję wywoływaną po usunięciu serii z powodu limitu pamięci lub wieku.
+    void setEvictionHandler(std::function<void(int sensorId)> handler) { onEvict = std::move(handler); }
+
+    /// @brief Ustawia maksymalny wiek wpisu w sekundach (0 = bez limitu).
+    void setMaxAge(qint64 seconds) { maxAgeSecs = seconds; }
+
+    /**
+     * @brief Wyszukuje serię sensora i oznacza ją jako ostatnio używaną.
+     * @return true, jeśli seria była w pamięci podręcznej.
+     */
+    bool lookup(int sensorId, QList<Measurement> *series);
+
+    /// @brief Dodaje lub zastępuje serię sensora.
+    void insert(int sensorId, const QList<Measurement> &series);
+
+    /// @brief Usuwa serię sensora.
+    void remove(int sensorId);
+
+    bool contains(int sensorId) const { return entries.contains(sensorId); }
+
+    /// @brief Przypina sensor - jego seria nie będzie usuwana przy braku miejsca.
+    void pin(int sensorId);
+    void unpin(int sensorId);
+    bool isPinned(int sensorId) const { return pinned.contains(sensorId); }
+
+    SeriesCacheStats stats() const;
+
+    /// @brief Szacuje rozmiar serii w pamięci.
+    static qint64 estimateBytes(const QList<Measurement> &series);
+
+private:
+    struct Entry {
+        QList<Measurement> series;
+        qint64 bytes;
+        QElapsedTimer age; ///< Czas monotoniczny - niezależny od zmian czasu letniego.
+        std::list<int>::iterator lruPosition;
+    };
+
+    void evict();
+
+    QHash<int, Entry> entries;
+    std::list<int> lru; ///< Od najdawniej do ostatnio używanego.
+    QSet<int> pinned;
+    std::function<void(int)> onEvict;
+    qint64 budget;
+    qint64 maxAgeSecs = 0;
+    qint64 usedBytes = 0;
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 evictions = 0;
+};
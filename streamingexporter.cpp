@@ -0,0 +1,342 @@
+#include "StreamingExporter.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+BufferedWriter::BufferedWriter(QIODevice *device, qsizetype capacity)
+    : device(device), capacity(capacity) {
+    buffer.reserve(capacity);
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+}
+
+void BufferedWriter::write(const char *data, qsizetype size) {
+    if (buffer.size() + size > capacity) {
+        flush();
+        // Duże porcje omijają bufor
+        if (size >= capacity) {
+            if (device->write(data, size) != size) {
+                error = true;
+            }
+            written += size;
+            return;
+        }
+    }
+    buffer.append(data, size);
+}
+
+bool BufferedWriter::flush() {
+    if (!buffer.isEmpty()) {
+        if (device->write(buffer) != buffer.size()) {
+            error = true;
+        }
+        written += buffer.size();
+        buffer.clear();
+    }
+    return !error;
+}
+
+namespace {
+
+char *writeDigits(char *p, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        p[i] = char('0' + value % 10);
+        value /= 10;
+    }
+    return p + width;
+}
+
+/// Zapisuje datę w formacie ISO (yyyy-MM-ddTHH:mm:ss) bez tworzenia QString.
+char *writeDateTime(char *p, const QDateTime &dateTime) {
+    if (!dateTime.isValid()) {
+        return p;
+    }
+    const QDate date = dateTime.date();
+    const QTime time = dateTime.time();
+    p = writeDigits(p, date.year(), 4);
+    *p++ = '-';
+    p = writeDigits(p, date.month(), 2);
+    *p++ = '-';
+    p = writeDigits(p, date.day(), 2);
+    *p++ = 'T';
+    p = writeDigits(p, time.hour(), 2);
+    *p++ = ':';
+    p = writeDigits(p, time.minute(), 2);
+    *p++ = ':';
+    p = writeDigits(p, time.second(), 2);
+    return p;
+}
+
+QByteArray csvField(const QString &text) {
+    QByteArray utf8 = text.toUtf8();
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n')) {
+        utf8.replace("\"", "\"\"");
+        return '"' + utf8 + '"';
+    }
+    return utf8;
+}
+
+bool inRange(const QDateTime &dateTime, const ExportFilter &filter) {
+    return (!filter.from.isValid() || dateTime >= filter.from) &&
+           (!filter.to.isValid() || dateTime <= filter.to);
+}
+
+/// Przechodzi po wszystkich seriach spełniających filtr bez kopiowania danych.
+template<typename SeriesFn>
+void forEachSeries(const QHash<int, QList<Sensor>> &sensorsByStation,
+                   const QHash<int, QList<Measurement>> &seriesBySensor,
+                   const ExportFilter &filter, SeriesFn fn) {
+    QList<int> stationIds = sensorsByStation.keys();
+    std::sort(stationIds.begin(), stationIds.end());
+    for (int stationId : stationIds) {
+        if (!filter.stationIds.isEmpty() && !filter.stationIds.contains(stationId)) {
+            continue;
+        }
+        for (const auto &sensor : sensorsByStation[stationId]) {
+            auto it = seriesBySensor.constFind(sensor.id);
+            if (it != seriesBySensor.constEnd() && !it.value().isEmpty()) {
+                fn(stationId, sensor.id, it.value());
+            }
+        }
+    }
+}
+
+qint64 writeCsvRows(BufferedWriter &writer, int stationId, int sensorId,
+                    const QList<Measurement> &series, const ExportFilter &filter) {
+    if (series.isEmpty()) {
+        return 0;
+    }
+    qint64 rows = 0;
+    const QByteArray param = csvField(series.first().paramName);
+    char prefix[32];
+    char *p = std::to_chars(prefix, prefix + sizeof(prefix), stationId).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, prefix + sizeof(prefix), sensorId).ptr;
+    *p++ = ',';
+    const qsizetype prefixSize = p - prefix;
+
+    char line[64];
+    for (const auto &m : series) {
+        if (!inRange(m.dateTime, filter)) {
+            continue;
+        }
+        writer.write(prefix, prefixSize);
+        writer.write(param);
+        char *q = line;
+        *q++ = ',';
+        q = writeDateTime(q, m.dateTime);
+        *q++ = ',';
+        // Brak pomiaru zapisywany jako puste pole
+        if (m.value >= 0) {
+            q = std::to_chars(q, line + sizeof(line) - 1, m.value).ptr;
+        }
+        *q++ = '\n';
+        writer.write(line, q - line);
+        rows++;
+    }
+    return rows;
+}
+
+qint64 exportCsv(BufferedWriter &writer, const QHash<int, QList<Sensor>> &sensorsByStation,
+                 const QHash<int, QList<Measurement>> &seriesBySensor, const ExportFilter &filter) {
+    qint64 rows = 0;
+    writer.write(QByteArray("stationId,sensorId,paramName,dateTime,value\n"));
+
+    forEachSeries(sensorsByStation, seriesBySensor, filter,
+                  [&](int stationId, int sensorId, const QList<Measurement> &series) {
+        rows += writeCsvRows(writer, stationId, sensorId, series, filter);
+    });
+    return rows;
+}
+
+template<typename T>
+void writeColumn(BufferedWriter &writer, const QVector<T> &column) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    writer.write(reinterpret_cast<const char*>(column.constData()), column.size() * qsizetype(sizeof(T)));
+#else
+    for (T v : column) {
+        writer.writeLittleEndian(v);
+    }
+#endif
+}
+
+qint64 exportColumnar(BufferedWriter &writer, const QHash<int, QList<Sensor>> &sensorsByStation,
+                      const QHash<int, QList<Measurement>> &seriesBySensor, const ExportFilter &filter) {
+    qint64 rows = 0;
+    writer.write("AQCOL1\0\0", 8);
+
+    QVector<qint32> stationColumn;
+    QVector<qint32> sensorColumn;
+    QVector<qint64> timeColumn;
+    QVector<double> valueColumn;
+    stationColumn.reserve(StreamingExporter::kBlockRows);
+    sensorColumn.reserve(StreamingExporter::kBlockRows);
+    timeColumn.reserve(StreamingExporter::kBlockRows);
+    valueColumn.reserve(StreamingExporter::kBlockRows);
+
+    auto flushBlock = [&]() {
+        writer.writeLittleEndian(quint32(stationColumn.size()));
+        writeColumn(writer, stationColumn);
+        writeColumn(writer, sensorColumn);
+        writeColumn(writer, timeColumn);
+        writeColumn(writer, valueColumn);
+        stationColumn.clear();
+        sensorColumn.clear();
+        timeColumn.clear();
+        valueColumn.clear();
+    };
+
+    forEachSeries(sensorsByStation, seriesBySensor, filter,
+                  [&](int stationId, int sensorId, const QList<Measurement> &series) {
+        for (const auto &m : series) {
+            if (!inRange(m.dateTime, filter)) {
+                continue;
+            }
+            stationColumn.append(stationId);
+            sensorColumn.append(sensorId);
+            timeColumn.append(m.dateTime.toMSecsSinceEpoch());
+            valueColumn.append(m.value >= 0 ? m.value : std::numeric_limits<double>::quiet_NaN());
+            rows++;
+            if (stationColumn.size() == StreamingExporter::kBlockRows) {
+                flushBlock();
+            }
+        }
+    });
+
+    if (!stationColumn.isEmpty()) {
+        flushBlock();
+    }
+    writer.writeLittleEndian(quint32(0));
+    return rows;
+}
+
+} // namespace
+
+ExportStats StreamingExporter::exportToFile(const QString &fileName, Format format,
+                                            const QHash<int, QList<Sensor>> &sensorsByStation,
+                                            const QHash<int, QList<Measurement>> &seriesBySensor,
+                                            const ExportFilter &filter) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        ExportStats stats;
+        stats.ok = false;
+        return stats;
+    }
+    return exportToDevice(&file, format, sensorsByStation, seriesBySensor, filter);
+}
+
+ExportStats StreamingExporter::exportToDevice(QIODevice *device, Format format,
+                                              const QHash<int, QList<Sensor>> &sensorsByStation,
+                                              const QHash<int, QList<Measurement>> &seriesBySensor,
+                                              const ExportFilter &filter) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ExportStats stats;
+    BufferedWriter writer(device);
+    if (format == Format::Csv) {
+        stats.rows = exportCsv(writer, sensorsByStation, seriesBySensor, filter);
+    } else {
+        stats.rows = exportColumnar(writer, sensorsByStation, seriesBySensor, filter);
+    }
+    stats.ok = writer.flush();
+    stats.bytes = writer.bytesWritten();
+    stats.elapsedMs = timer.elapsed();
+    stats.rowsPerSecond = stats.rows * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+    return stats;
+}
+
+ExportStats StreamingExporter::appendCsv(QIODevice *device, int stationId, int sensorId,
+                                         const QList<Measurement> &series) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ExportStats stats;
+    BufferedWriter writer(device);
+    stats.rows = writeCsvRows(writer, stationId, sensorId, series, ExportFilter());
+    stats.ok = writer.flush();
+    stats.bytes = writer.bytesWritten();
+    stats.elapsedMs = timer.elapsed();
+    stats.rowsPerSecond = stats.rows * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+    return stats;
+}
+
+QHash<int, QList<Measurement>> StreamingExporter::readCsv(QIODevice *device, QHash<int, int> *stationBySensor) {
+    QHash<int, QList<Measurement>> seriesBySensor;
+    QHash<QByteArray, QString> paramNames;
+
+    while (!device->atEnd()) {
+        const QByteArray line = device->readLine();
+        // Niekompletny ostatni wiersz (np. po przerwanym zapisie) jest pomijany
+        if (!line.endsWith('\n')) {
+            break;
+        }
+
+        const qsizetype c1 = line.indexOf(',');
+        const qsizetype c2 = line.indexOf(',', c1 + 1);
+        if (c1 < 0 || c2 < 0) {
+            continue;
+        }
+        bool okStation = false;
+        bool okSensor = false;
+        const int stationId = line.left(c1).toInt(&okStation);
+        const int sensorId = line.mid(c1 + 1, c2 - c1 - 1).toInt(&okSensor);
+        if (!okStation || !okSensor) {
+            continue; // nagłówek lub uszkodzony wiersz
+        }
+
+        qsizetype pos = c2 + 1;
+        QByteArray param;
+        if (line.at(pos) == '"') {
+            for (++pos; pos < line.size(); ++pos) {
+                if (line.at(pos) == '"') {
+                    if (pos + 1 < line.size() && line.at(pos + 1) == '"') {
+                        param += '"';
+                        ++pos;
+                    } else {
+                        ++pos;
+                        break;
+                    }
+                } else {
+                    param += line.at(pos);
+                }
+            }
+        } else {
+            const qsizetype end = line.indexOf(',', pos);
+            param = line.mid(pos, end - pos);
+            pos = end;
+        }
+        if (pos < 0 || pos >= line.size() || line.at(pos) != ',') {
+            continue;
+        }
+
+        const qsizetype c4 = line.indexOf(',', pos + 1);
+        if (c4 < 0) {
+            continue;
+        }
+        const QByteArray valueField = line.mid(c4 + 1).trimmed();
+        bool okValue = true;
+
+        Measurement m;
+        // Wspólny QString dla powtarzających się nazw parametrów
+        auto name = paramNames.constFind(param);
+        if (name == paramNames.constEnd()) {
+            name = paramNames.insert(param, QString::fromUtf8(param));
+        }
+        m.paramName = name.value();
+        m.dateTime = QDateTime::fromString(QString::fromLatin1(line.mid(pos + 1, c4 - pos - 1)), Qt::ISODate);
+        m.value = valueField.isEmpty() ? std::numeric_limits<double>::quiet_NaN() : valueField.toDouble(&okValue);
+        if (!okValue || !m.dateTime.isValid()) {
+            continue;
+        }
+        seriesBySensor[sensorId].append(m);
+        if (stationBySensor) {
+            stationBySensor->insert(sensorId, stationId);
+        }
+    }
+    return seriesBySensor;
+}
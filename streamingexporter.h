@@ -0,0 +1,102 @@
+#pragma once
+#include <QIODevice>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QtEndian>
+#include "AirQualityManager.h"
+
+/**
+ * @class BufferedWriter
+ * @brief Zapisuje dane do urządzenia porcjami o stałym rozmiarze bufora.
+ */
+class BufferedWriter {
+public:
+    explicit BufferedWriter(QIODevice *device, qsizetype capacity = 64 * 1024);
+    ~BufferedWriter();
+
+    void write(const char *data, qsizetype size);
+    void write(const QByteArray &data) { write(data.constData(), data.size()); }
+    void write(char c) { write(&c, 1); }
+
+    /// @brief Zapisuje wartość liczbową w kolejności little-endian.
+    template<typename T>
+    void writeLittleEndian(T value) {
+        T le = qToLittleEndian(value);
+        write(reinterpret_cast<const char*>(&le), sizeof(T));
+    }
+
+    /// @brief Opróżnia bufor do urządzenia.
+    bool flush();
+
+    qint64 bytesWritten() const { return written + buffer.size(); }
+    bool hasError() const { return error; }
+
+private:
+    QIODevice *device;
+    QByteArray buffer;
+    qsizetype capacity;
+    qint64 written = 0;
+    bool error = false;
+};
+
+/**
+ * @struct ExportFilter
+ * @brief Filtr eksportu: zakres czasu i stacje (puste = bez ograniczeń).
+ */
+struct ExportFilter {
+    QDateTime from;
+    QDateTime to;
+    QSet<int> stationIds;
+};
+
+/**
+ * @struct ExportStats
+ * @brief Podsumowanie eksportu.
+ */
+struct ExportStats {
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    qint64 elapsedMs = 0;
+    double rowsPerSecond = 0.0;
+    bool ok = true;
+};
+
+/**
+ * @class StreamingExporter
+ * @brief Eksportuje pomiary do CSV lub binarnego formatu kolumnowego bez budowania dokumentu w pamięci.
+ *
+ * Format kolumnowy: nagłówek "AQCOL1\0\0", następnie bloki (do kBlockRows wierszy):
+ * uint32 liczba wierszy, int32 stationId[], int32 sensorId[], int64 czas w ms od epoki[],
+ * double wartość[] (NaN = brak pomiaru). Plik kończy blok o zerowej liczbie wierszy.
+ * Wszystkie liczby zapisywane są w kolejności little-endian.
+ */
+class StreamingExporter {
+public:
+    enum class Format { Csv, Columnar };
+
+    static constexpr int kBlockRows = 16 * 1024;
+
+    /// @brief Eksportuje pomiary do pliku w podanym formacie.
+    static ExportStats exportToFile(const QString &fileName, Format format,
+                                    const QHash<int, QList<Sensor>> &sensorsByStation,
+                                    const QHash<int, QList<Measurement>> &seriesBySensor,
+                                    const ExportFilter &filter = ExportFilter());
+
+    /// @brief Eksportuje pomiary do urządzenia w podanym formacie.
+    static ExportStats exportToDevice(QIODevice *device, Format format,
+                                      const QHash<int, QList<Sensor>> &sensorsByStation,
+                                      const QHash<int, QList<Measurement>> &seriesBySensor,
+                                      const ExportFilter &filter = ExportFilter());
+
+    /// @brief Dopisuje do urządzenia wiersze CSV jednej serii (bez nagłówka).
+    static ExportStats appendCsv(QIODevice *device, int stationId, int sensorId,
+                                 const QList<Measurement> &series);
+
+    /**
+     * @brief Wczytuje serie z pliku CSV (klucz: id sensora); pomija nagłówek i niekompletne wiersze.
+     * @param stationBySensor Jeśli podane, otrzymuje id stacji każdego wczytanego sensora.
+     */
+    static QHash<int, QList<Measurement>> readCsv(QIODevice *device, QHash<int, int> *stationBySensor = nullptr);
+};
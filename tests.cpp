@@ -1,5 +1,17 @@
 #include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QBuffer>
+#include <QTcpSocket>
 #include "MainWindow.h"
+#include "AqiCalculator.h"
+#include "DataRepository.h"
+#include "QueryServer.h"
+#include "StreamingExporter.h"
+#include "SeriesCache.h"
+#include "CorrelationMatrix.h"
+#include "BackfillPipeline.h"
 
 /**
  * @class TestAirQualityMonitor
@@ -48,6 +60,501 @@ private slots:
         QVERIFY(analysisText.contains("Średnia wartość: 27.5"));
         QVERIFY(analysisText.contains("Trend: Rosnący"));
     }
+    /**
+     * @brief Testuje indeksy cząstkowe i wsadowe obliczanie indeksu dla stacji.
+     */
+    void testAqiBatch() {
+        QCOMPARE(AqiCalculator::pollutantIndex("PM10"), 0);
+        QCOMPARE(AqiCalculator::pollutantIndex("dwutlenek azotu"), 3);
+        QCOMPARE(AqiCalculator::subIndex(0, 10.0), 0);
+        QCOMPARE(AqiCalculator::subIndex(0, 60.0), 2);
+        QCOMPARE(AqiCalculator::subIndex(0, -1.0), -1);
+        // Wartość równa progowi należy do niższej klasy
+        QCOMPARE(AqiCalculator::subIndex(0, 20.0), 0);
+        QCOMPARE(AqiCalculator::subIndex(0, 20.1), 1);
+        QCOMPARE(AqiCalculator::subIndex(0, 150.0), 4);
+        QCOMPARE(AqiCalculator::subIndex(0, 150.1), 5);
+
+        QDateTime start = QDateTime::fromString("2025-04-10T00:00:00", Qt::ISODate);
+        auto makeSeries = [&](const QString &param, const QList<double> &values) {
+            QList<Measurement> list;
+            for (int h = 0; h < values.size(); ++h) {
+                list.append({ param, values[h], start.addSecs(h * 3600) });
+            }
+            return list;
+        };
+
+        QHash<int, QList<QList<Measurement>>> data;
+        data[1] = { makeSeries("PM10", { 10.0, 60.0, -1.0 }), makeSeries("NO2", { 120.0, 10.0, -1.0 }) };
+        data[2] = { makeSeries("PM10", { 5.0, 5.0, 5.0 }) };
+        data[3] = { makeSeries("PM10", { 20.0, 50.0, 50.1 }) };
+
+        AqiGrid grid = AqiCalculator::computeBatch(data, start, 3);
+        QCOMPARE(grid.stationIds, QList<int>({ 1, 2, 3 }));
+        QCOMPARE(int(grid.at(0, 0)), 2);
+        QCOMPARE(int(grid.at(0, 1)), 2);
+        QCOMPARE(int(grid.at(0, 2)), -1);
+        QCOMPARE(int(grid.at(1, 2)), 0);
+        QCOMPARE(int(grid.at(2, 0)), 0);
+        QCOMPARE(int(grid.at(2, 1)), 1);
+        QCOMPARE(int(grid.at(2, 2)), 2);
+
+        QList<StationRank> ranking = AqiCalculator::rankStations(grid, 2);
+        QCOMPARE(ranking.first().stationId, 2);
+        QCOMPARE(ranking.last().index, -1);
+    }
+    /**
+     * @brief Mierzy czas odświeżenia indeksu dla całej sieci (300 stacji, 30 dni).
+     */
+    void benchmarkAqiBatch() {
+        QDateTime start = QDateTime::fromString("2025-03-01T00:00:00", Qt::ISODate);
+        const int hours = 30 * 24;
+        QHash<int, QList<QList<Measurement>>> data;
+        for (int station = 0; station < 300; ++station) {
+            for (int p = 0; p < int(kPollutants.size()); ++p) {
+                QList<Measurement> list;
+                list.reserve(hours);
+                for (int h = 0; h < hours; ++h) {
+                    list.append({ kPollutants[p].code, double((station * 7 + h * 13 + p) % 200), start.addSecs(h * 3600) });
+                }
+                data[station].append(list);
+            }
+        }
+
+        AqiGrid grid;
+        QBENCHMARK {
+            grid = AqiCalculator::computeBatch(data, start, hours);
+        }
+        QCOMPARE(grid.stationIds.size(), 300);
+    }
+    /**
+     * @brief Testuje odpowiedzi serwera zapytań i unieważnianie pamięci podręcznej.
+     */
+    void testQueryServer() {
+        DataRepository repository;
+        QueryServer server(&repository);
+        repository.publishStations({ { 1, "Poznań Polanka", 52.4, 16.9 } });
+        repository.publishSensors(1, { { 10, "pył zawieszony PM10" } });
+
+        QDateTime start = QDateTime::fromString("2025-04-10T12:00:00", Qt::ISODate);
+        repository.publishMeasurements(10, { { "PM10", 20.0, start }, { "PM10", -1.0, start.addSecs(3600) },
+                                     { "PM10", 40.0, start.addSecs(7200) } });
+
+        QueryResponse stationsResponse = server.handleRequest("GET", "/stations");
+        QCOMPARE(stationsResponse.status, 200);
+        QCOMPARE(QJsonDocument::fromJson(stationsResponse.body).array().first().toObject()["id"].toInt(), 1);
+
+        QueryResponse series = server.handleRequest("GET", "/sensors/10/series?from=2025-04-10T13:00:00");
+        QJsonArray values = QJsonDocument::fromJson(series.body).object()["values"].toArray();
+        QCOMPARE(values.size(), 2);
+        QVERIFY(values.first().toObject()["value"].isNull());
+
+        QueryResponse aggregate = server.handleRequest("GET", "/sensors/10/aggregate");
+        QJsonObject stats = QJsonDocument::fromJson(aggregate.body).object();
+        QCOMPARE(stats["count"].toInt(), 2);
+        QCOMPARE(stats["avg"].toDouble(), 30.0);
+
+        repository.publishMeasurements(10, { { "PM10", 50.0, start } });
+        stats = QJsonDocument::fromJson(server.handleRequest("GET", "/sensors/10/aggregate").body).object();
+        QCOMPARE(stats["count"].toInt(), 1);
+
+        QCOMPARE(server.handleRequest("GET", "/sensors/99/series").status, 404);
+        QCOMPARE(server.handleRequest("POST", "/stations").status, 405);
+
+        // Niepoprawny Content-Length kończy się błędem 400 i zamknięciem połączenia
+        QVERIFY(server.start(0, 1));
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(client.waitForConnected(3000));
+        client.write("GET /stations HTTP/1.1\r\nContent-Length: -100000\r\n\r\n");
+        QByteArray reply;
+        while (client.waitForReadyRead(3000)) {
+            reply += client.readAll();
+        }
+        QVERIFY(reply.startsWith("HTTP/1.1 400"));
+        QCOMPARE(reply.count("HTTP/1.1"), qsizetype(1));
+        QCOMPARE(client.state(), QAbstractSocket::UnconnectedState);
+        server.stop();
+
+        // listen() bez start() nie ma wątków roboczych - połączenie jest zamykane
+        QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+        QTcpSocket direct;
+        direct.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(direct.waitForConnected(3000));
+        QVERIFY(direct.state() == QAbstractSocket::UnconnectedState || direct.waitForDisconnected(3000));
+        server.stop();
+    }
+    /**
+     * @brief Testuje strumieniowy eksport do CSV i formatu kolumnowego z filtrami.
+     */
+    void testStreamingExport() {
+        QDateTime start = QDateTime::fromString("2025-04-10T12:00:00", Qt::ISODate);
+        QHash<int, QList<Sensor>> sensorsByStation;
+        sensorsByStation[1] = { { 10, "pył zawieszony PM10" } };
+        sensorsByStation[2] = { { 20, "ozon" } };
+        QHash<int, QList<Measurement>> seriesBySensor;
+        seriesBySensor[10] = { { "PM10", 25.5, start }, { "PM10", -1.0, start.addSecs(3600) },
+                               { "PM10", 30.0, start.addSecs(7200) } };
+        seriesBySensor[20] = { { "O3", 80.0, start } };
+
+        ExportFilter filter;
+        filter.to = start.addSecs(3600);
+        filter.stationIds = { 1 };
+
+        QBuffer csv;
+        csv.open(QIODevice::WriteOnly);
+        ExportStats stats = StreamingExporter::exportToDevice(&csv, StreamingExporter::Format::Csv,
+                                                              sensorsByStation, seriesBySensor, filter);
+        QVERIFY(stats.ok);
+        QCOMPARE(stats.rows, qint64(2));
+        QCOMPARE(csv.data(), QByteArray("stationId,sensorId,paramName,dateTime,value\n"
+                                        "1,10,PM10,2025-04-10T12:00:00,25.5\n"
+                                        "1,10,PM10,2025-04-10T13:00:00,\n"));
+
+        QBuffer columnar;
+        columnar.open(QIODevice::WriteOnly);
+        stats = StreamingExporter::exportToDevice(&columnar, StreamingExporter::Format::Columnar,
+                                                  sensorsByStation, seriesBySensor);
+        QCOMPARE(stats.rows, qint64(4));
+        const QByteArray data = columnar.data();
+        QVERIFY(data.startsWith(QByteArray("AQCOL1\0\0", 8)));
+        QCOMPARE(qFromLittleEndian<quint32>(data.constData() + 8), quint32(4));
+        QCOMPARE(data.size(), qsizetype(8 + 4 + 4 * (4 + 4 + 8 + 8) + 4));
+    }
+    /**
+     * @brief Sprawdza, że czytelnicy repozytorium widzą spójne migawki i nie są blokowani przez zapis.
+     */
+    void testDataRepositoryConcurrentReaders() {
+        DataRepository repository;
+        QAtomicInt stop(0);
+        QAtomicInt inconsistent(0);
+        QAtomicInteger<qint64> reads(0);
+
+        // Zapis: każda wersja ma tyle stacji, ile pomiarów w serii sensora 1
+        QThread *writer = QThread::create([&]() {
+            QDateTime start = QDateTime::currentDateTime();
+            int n = 0;
+            while (!stop.loadRelaxed()) {
+                ++n;
+                QList<Measurement> series(n * 10, Measurement{ "PM10", 1.0, start });
+                QList<Station> stationList(n * 10, Station{ 1, "Stacja", 0.0, 0.0 });
+                repository.update([&](DataSnapshot &data) {
+                    data.seriesBySensor[1] = series;
+                    data.stations = stationList;
+                });
+                if (n == 500) {
+                    n = 0;
+                }
+            }
+        });
+
+        QList<QThread*> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.append(QThread::create([&]() {
+                while (!stop.loadRelaxed()) {
+                    std::shared_ptr<const DataSnapshot> data = repository.snapshot();
+                    if (data->stations.size() != data->seriesBySensor.value(1).size()) {
+                        inconsistent.fetchAndAddRelaxed(1);
+                    }
+                    reads.fetchAndAddRelaxed(1);
+                }
+            }));
+        }
+
+        writer->start();
+        for (auto *r : readers) {
+            r->start();
+        }
+        QThread::msleep(300);
+        stop.storeRelaxed(1);
+        writer->wait();
+        for (auto *r : readers) {
+            r->wait();
+            delete r;
+        }
+        delete writer;
+
+        QCOMPARE(inconsistent.loadRelaxed(), 0);
+        QVERIFY(repository.snapshot()->version > 0);
+        QVERIFY(reads.loadRelaxed() > repository.snapshot()->version);
+
+        // Zapis zatrzymany wewnątrz update(): czytelnicy muszą dalej pobierać poprzednią migawkę
+        const quint64 versionBefore = repository.snapshot()->version;
+        QSemaphore entered;
+        QSemaphore release;
+        QThread *heldWriter = QThread::create([&]() {
+            repository.update([&](DataSnapshot &data) {
+                entered.release();
+                release.acquire();
+                data.stations.clear();
+            });
+        });
+        heldWriter->start();
+        QVERIFY(entered.tryAcquire(1, 5000));
+
+        const int readsPerThread = 10000;
+        QAtomicInt oldVersionReads(0);
+        QAtomicInteger<qint64> maxReadNs(0);
+        readers.clear();
+        for (int i = 0; i < 4; ++i) {
+            readers.append(QThread::create([&]() {
+                QElapsedTimer timer;
+                for (int k = 0; k < readsPerThread; ++k) {
+                    timer.start();
+                    std::shared_ptr<const DataSnapshot> data = repository.snapshot();
+                    const qint64 ns = timer.nsecsElapsed();
+                    if (data->version == versionBefore) {
+                        oldVersionReads.fetchAndAddRelaxed(1);
+                    }
+                    qint64 previous = maxReadNs.loadRelaxed();
+                    while (ns > previous && !maxReadNs.testAndSetRelaxed(previous, ns, previous)) {}
+                }
+            }));
+        }
+        for (auto *r : readers) {
+            r->start();
+        }
+        bool readersDone = true;
+        for (auto *r : readers) {
+            readersDone = r->wait(5000) && readersDone;
+        }
+        release.release();
+        heldWriter->wait();
+        delete heldWriter;
+        QVERIFY(readersDone);
+        qDeleteAll(readers);
+
+        QCOMPARE(oldVersionReads.loadRelaxed(), 4 * readsPerThread);
+        // Pobranie migawki nie czeka na zapis - nawet przy przeplocie wątków mieści się w 100 ms
+        QVERIFY(maxReadNs.loadRelaxed() < 100 * 1000 * 1000);
+        QCOMPARE(repository.snapshot()->version, versionBefore + 1);
+    }
+    /**
+     * @brief Testuje limit pamięci, usuwanie LRU, przypinanie i statystyki pamięci podręcznej serii.
+     */
+    void testSeriesCache() {
+        QDateTime start = QDateTime::fromString("2025-04-10T12:00:00", Qt::ISODate);
+        QList<Measurement> series(100, Measurement{ "PM10", 10.0, start });
+        const qint64 entryBytes = SeriesCache::estimateBytes(series);
+
+        SeriesCache cache(entryBytes * 3);
+        cache.pin(1);
+        for (int sensorId = 1; sensorId <= 3; ++sensorId) {
+            cache.insert(sensorId, series);
+        }
+
+        QList<Measurement> result;
+        QVERIFY(cache.lookup(2, &result));
+        QCOMPARE(result.size(), 100);
+
+        // Najdawniej używany nieprzypięty sensor to 3 (1 jest przypięty, 2 był odczytany)
+        cache.insert(4, series);
+        QVERIFY(cache.contains(1));
+        QVERIFY(cache.contains(2));
+        QVERIFY(!cache.contains(3));
+        QVERIFY(!cache.lookup(3, &result));
+
+        SeriesCacheStats stats = cache.stats();
+        QCOMPARE(stats.hits, qint64(1));
+        QCOMPARE(stats.misses, qint64(1));
+        QCOMPARE(stats.evictions, qint64(1));
+        QCOMPARE(stats.entries, 3);
+        QVERIFY(stats.bytes <= cache.byteBudget());
+
+        cache.setByteBudget(entryBytes);
+        QVERIFY(cache.contains(1));
+        QCOMPARE(cache.stats().entries, 1);
+        // Wspólna nazwa parametru liczona jest raz, osobne kopie - dla każdego pomiaru
+        QList<Measurement> distinct = series;
+        for (auto &m : distinct) {
+            m.paramName = QString::fromLatin1("PM10");
+        }
+        QVERIFY(SeriesCache::estimateBytes(distinct) > entryBytes);
+
+        // Usunięcie z pamięci podręcznej usuwa serię z repozytorium - razem mieszczą się w limicie
+        DataRepository repository;
+        SeriesCache bounded(entryBytes * 5);
+        bounded.setEvictionHandler([&repository](int sensorId) {
+            repository.update([sensorId](DataSnapshot &data) {
+                data.seriesBySensor.remove(sensorId);
+            });
+        });
+        bounded.pin(1);
+        for (int sensorId = 1; sensorId <= 100; ++sensorId) {
+            QList<Measurement> fetched(100, Measurement{ "PM10", double(sensorId), start });
+            repository.publishMeasurements(sensorId, fetched);
+            bounded.insert(sensorId, fetched);
+        }
+        std::shared_ptr<const DataSnapshot> data = repository.snapshot();
+        qint64 repositoryBytes = 0;
+        for (const auto &stored : data->seriesBySensor) {
+            repositoryBytes += SeriesCache::estimateBytes(stored);
+        }
+        QVERIFY(repositoryBytes <= bounded.byteBudget());
+        QCOMPARE(int(data->seriesBySensor.size()), bounded.stats().entries);
+        QVERIFY(data->seriesBySensor.contains(1));
+        QVERIFY(data->seriesBySensor.contains(100));
+    }
+    /**
+     * @brief Testuje wyrównanie serii z lukami i macierz korelacji Pearsona/Spearmana.
+     */
+    void testCorrelationMatrix() {
+        QDateTime start = QDateTime::fromString("2025-04-10T00:00:00", Qt::ISODate);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        auto makeSeries = [&](const QList<double> &values) {
+            QList<Measurement> list;
+            for (int h = 0; h < values.size(); ++h) {
+                list.append({ "PM10", values[h], start.addSecs(h * 3600) });
+            }
+            return list;
+        };
+
+        QHash<int, QList<Measurement>> series;
+        series[1] = makeSeries({ 1, 2, 3, nan, 5, 6, 7, 8, 9, 10 });
+        series[2] = makeSeries({ 3, 5, 7, 9, 11, nan, 15, 17, 19, 21 });
+        series[3] = makeSeries({ 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 });
+        series[4] = makeSeries({ 1, 4, 9, 16, 25, 36, 49, 64, 81, 100 });
+        series[5] = makeSeries({ 2, 1, nan, 4, 3, 6, 5, 8, 7, 10 });
+
+        HourlyGrid grid = CorrelationMatrix::alignHourly(series, start, 10);
+        QCOMPARE(grid.ids, QList<int>({ 1, 2, 3, 4, 5 }));
+        QVERIFY(qIsNaN(grid.at(0, 3)));
+
+        CorrelationResult pearson = CorrelationMatrix::compute(grid, CorrelationMatrix::Method::Pearson);
+        QVERIFY(qAbs(pearson.at(0, 1) - 1.0f) < 1e-4f);
+        QVERIFY(qAbs(pearson.at(0, 2) + 1.0f) < 1e-4f);
+        QCOMPARE(pearson.at(2, 0), pearson.at(0, 2));
+        QVERIFY(qAbs(pearson.at(2, 3) + 0.974559f) < 1e-4f);
+
+        CorrelationResult spearman = CorrelationMatrix::compute(grid, CorrelationMatrix::Method::Spearman);
+        QVERIFY(qAbs(spearman.at(2, 3) + 1.0f) < 1e-4f);
+        // Różne luki: rangi tylko na wspólnych godzinach, więc obie rosnące serie dają dokładnie 1
+        QVERIFY(qAbs(spearman.at(0, 1) - 1.0f) < 1e-4f);
+        // Serie 1 i 5 (wspólne godziny 0,1,4..9): suma d^2 = 6, rho = 1 - 6 * 6 / (8 * 63) = 13/14
+        QVERIFY(qAbs(spearman.at(0, 4) - 13.0f / 14.0f) < 1e-4f);
+        QCOMPARE(spearman.at(4, 0), spearman.at(0, 4));
+
+        QCOMPARE(CorrelationMatrix::outliers(pearson, 0.0f), QList<int>({ 3 }));
+    }
+
+    /**
+     * @brief Mierzy czas obliczenia macierzy korelacji dla 1024 stacji (tydzień danych godzinowych).
+     */
+    void benchmarkCorrelationMatrix() {
+        HourlyGrid grid;
+        grid.hours = 7 * 24;
+        for (int i = 0; i < 1024; ++i) {
+            grid.ids.append(i);
+        }
+        grid.values.resize(qsizetype(grid.ids.size()) * grid.hours);
+        for (qsizetype i = 0; i < grid.values.size(); ++i) {
+            grid.values[i] = (i % 37 == 0) ? std::numeric_limits<float>::quiet_NaN() : float((i * 7919) % 113);
+        }
+
+        CorrelationResult result;
+        QBENCHMARK {
+            result = CorrelationMatrix::compute(grid);
+        }
+        QCOMPARE(result.matrix.size(), qsizetype(1024) * 1024);
+        QCOMPARE(result.at(5, 5), 1.0f);
+    }
+    /**
+     * @brief Testuje pobieranie danych historycznych z lokalnego serwera i wznawianie od punktu kontrolnego.
+     */
+    void testBackfillPipeline() {
+        QDateTime from = QDateTime::fromString("2025-04-01T00:00:00", Qt::ISODate);
+        QDateTime to = from.addDays(10);
+
+        // Lokalny odpowiednik archiwum: serwer zapytań nad osobnym repozytorium
+        DataRepository archive;
+        for (int sensorId : { 10, 11 }) {
+            QList<Measurement> series;
+            for (int h = 0; h < 240; ++h) {
+                series.append({ sensorId == 10 ? "PM10" : "NO2", double(h % 50), from.addSecs(h * 3600) });
+            }
+            archive.publishMeasurements(sensorId, series);
+        }
+        QueryServer server(&archive);
+        QVERIFY(server.start(0, 2));
+        const QString endpoint = "http://127.0.0.1:" + QString::number(server.serverPort()) +
+                                 "/sensors/%1/series?from=%2&to=%3";
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        auto configure = [&](BackfillPipeline &pipeline) {
+            pipeline.setEndpoint(endpoint);
+            pipeline.setCheckpointFile(dir.filePath("checkpoint.json"));
+            pipeline.setDataFile(dir.filePath("data.csv"));
+            pipeline.setChunkDays(2);
+            pipeline.setMaxConcurrentRequests(4);
+            pipeline.setRequestsPerSecond(200.0);
+        };
+
+        DataRepository local;
+        local.publishSensors(1, { { 10, "pył zawieszony PM10" }, { 11, "dwutlenek azotu" } });
+        BackfillPipeline pipeline(&local);
+        configure(pipeline);
+        QSignalSpy finishedSpy(&pipeline, &BackfillPipeline::finished);
+        QSignalSpy pipelineErrorSpy(&pipeline, &BackfillPipeline::errorOccurred);
+        // Sensor 12 nie jest przypisany do stacji - zostaje pominięty
+        pipeline.start({ 10, 11, 12 }, from, to);
+        QCOMPARE(pipelineErrorSpy.count(), 1);
+        QVERIFY(finishedSpy.wait(10000));
+        BackfillStats stats = finishedSpy.first().first().value<BackfillStats>();
+        QCOMPARE(stats.requests, qint64(10));
+        QCOMPARE(stats.points, qint64(480));
+        QCOMPARE(local.snapshot()->seriesBySensor.value(10).size(), 240);
+        QCOMPARE(pipeline.coverage(11).size(), 1);
+        QCOMPARE(pipeline.coverage(11).first().done, to);
+
+        // Po ponownym uruchomieniu dane są wczytywane z pliku, a pobierany jest tylko nowy zakres
+        DataRepository restarted;
+        BackfillPipeline resumed(&restarted);
+        configure(resumed);
+        QSignalSpy resumedSpy(&resumed, &BackfillPipeline::finished);
+        resumed.start({ 10, 11 }, from, to.addDays(1));
+        QVERIFY(resumedSpy.wait(10000));
+        stats = resumedSpy.first().first().value<BackfillStats>();
+        QCOMPARE(stats.requests, qint64(2));
+        QCOMPARE(restarted.snapshot()->seriesBySensor.value(10).size(), 240);
+        QCOMPARE(restarted.snapshot()->seriesBySensor.value(11).first().paramName, QString("NO2"));
+        // Przypisanie do stacji jest odtwarzane z pliku danych
+        QCOMPARE(restarted.snapshot()->sensorsByStation.value(1).size(), 2);
+        AqiGrid restoredIndex = AqiCalculator::computeBatch(*restarted.snapshot(), from, 24);
+        QCOMPARE(restoredIndex.stationIds, QList<int>({ 1 }));
+        QVERIFY(restoredIndex.at(0, 0) >= 0);
+
+        // Zakres rozszerzony wstecz: pobierane są tylko wcześniejsze dwa dni, nie od końca poprzedniego zakresu
+        const QDateTime earlier = from.addDays(-2);
+        for (int sensorId : { 10, 11 }) {
+            QList<Measurement> series;
+            for (int h = 0; h < 288; ++h) {
+                series.append({ sensorId == 10 ? "PM10" : "NO2", double(h % 50), earlier.addSecs(h * 3600) });
+            }
+            archive.publishMeasurements(sensorId, series);
+        }
+        DataRepository extended;
+        BackfillPipeline backwards(&extended);
+        configure(backwards);
+        QSignalSpy backwardsSpy(&backwards, &BackfillPipeline::finished);
+        backwards.start({ 10, 11 }, earlier, to.addDays(1));
+        QVERIFY(backwardsSpy.wait(10000));
+        stats = backwardsSpy.first().first().value<BackfillStats>();
+        QCOMPARE(stats.requests, qint64(2));
+        QCOMPARE(stats.points, qint64(96));
+        QCOMPARE(extended.snapshot()->seriesBySensor.value(10).size(), 288);
+        QCOMPARE(extended.snapshot()->seriesBySensor.value(10).first().dateTime, earlier);
+        QCOMPARE(backwards.coverage(10).size(), 1);
+        QCOMPARE(backwards.coverage(10).first().start, earlier);
+        QCOMPARE(backwards.coverage(10).first().done, to.addDays(1));
+
+        // Bez adresu archiwum pobieranie nie startuje
+        BackfillPipeline unconfigured(&extended);
+        QSignalSpy errorSpy(&unconfigured, &BackfillPipeline::errorOccurred);
+        unconfigured.start({ 10 }, from, to);
+        QCOMPARE(errorSpy.count(), 1);
+        QVERIFY(!unconfigured.isRunning());
+    }
 };
 
 QTEST_MAIN(TestAirQualityMonitor)